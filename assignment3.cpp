@@ -3,9 +3,26 @@
 #include <map>
 #include <sstream>
 #include <vector>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
+#include "compressedgraph.h"
+#include "concurrentgraph.h"
+#include "externalgraph.h"
 #include "graph.h"
+#include "kshortestpaths.h"
+#include "partition.h"
+#include "relaxkernel.h"
+#include "shardedgraph.h"
+#include "shortestpath.h"
+#include "spanningtree.h"
+#include "streamvbyte.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // This is 80 characters - Keep all lines under 80 characters                 //
@@ -168,6 +185,1273 @@ void testGraphReadFile() {
    assert(testGraph1.getNumEdges() == 3);
    assert(testGraph2.getNumEdges() == 9);
    assert(testGraph3.getNumEdges() == 24);
+   // labels and weights are whitespace-separated tokens, so an edge may
+   // be split over lines and a weight may carry a sign
+   const std::string path = "readfiletest.txt";
+   std::ofstream out(path);
+   out << "3\nA B +5\nB\nC\n-2\n  C   A 7 trailing words\n";
+   out.close();
+   Graph testGraph4;
+   testGraph4.readFile(path);
+   std::remove(path.c_str());
+   assert(testGraph4.getNumEdges() == 3);
+   assert(testGraph4.getEdgeWeight("A", "B") == 5);
+   assert(testGraph4.getEdgeWeight("B", "C") == -2);
+   assert(testGraph4.getEdgeWeight("C", "A") == 7);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests traversals with lambdas, pruning and stopping early
+void testGraphLambdaVisitor() {
+   std::cout << "Testing Graph traversal with lambda visitors:" << std::endl;
+   Graph testGraph;
+   testGraph.add("A", "B", 1);
+   testGraph.add("A", "C", 1);
+   testGraph.add("B", "D", 1);
+   testGraph.add("C", "E", 1);
+   std::string order;
+   testGraph.depthFirstTraversal("A", [&order](const auto& v) {
+      order += v.getLabel();
+   });
+   assert(order == "ABDCE");
+   order = "";
+   testGraph.breadthFirstTraversal("A", [&order](const std::string& label) {
+      order += label;
+   });
+   assert(order == "ABCDE");
+   // IDs are handed out in order of creation
+   std::vector<int> ids;
+   testGraph.breadthFirstTraversal("A", [&ids](const auto& v) {
+      ids.push_back(v.getId());
+   });
+   assert((ids == std::vector<int>{0, 1, 2, 3, 4}));
+   // Prune B so D is never reached
+   order = "";
+   testGraph.depthFirstTraversal("A", [&order](const auto& v) {
+      order += v.getLabel();
+      return v.getLabel() == "B" ? VisitAction::Prune
+                                 : VisitAction::Continue;
+   });
+   assert(order == "ABCE");
+   // Stop as soon as C is found
+   order = "";
+   testGraph.breadthFirstTraversal("A", [&order](const auto& v) {
+      order += v.getLabel();
+      return v.getLabel() != "C";
+   });
+   assert(order == "ABC");
+   // Unknown start vertex visits nothing
+   order = "";
+   testGraph.depthFirstTraversal("Z", [&order](const auto& v) {
+      order += v.getLabel();
+   });
+   assert(order.empty());
+   // A path far deeper than the call stack could hold as recursion
+   Graph chain;
+   const int chainLength = 200000;
+   for (int i = 0; i + 1 < chainLength; i++) {
+      chain.add(std::to_string(i), std::to_string(i + 1), 1);
+   }
+   int visited = 0;
+   bool inOrder = true;
+   chain.depthFirstTraversal("0", [&](const std::string& label) {
+      inOrder = inOrder && label == std::to_string(visited);
+      visited++;
+   });
+   assert(visited == chainLength && inOrder);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests the open addressing map used by NeighborOrder::Insertion
+void testLabelHashMap() {
+   std::cout << "Testing LabelHashMap:" << std::endl;
+   LabelHashMap<int> testMap;
+   assert(testMap.find("A") == nullptr);
+   for (int i = 0; i < 1000; i++) {
+      assert(testMap.insert(std::to_string(i), i).second);
+   }
+   assert(!testMap.insert("7", 70).second);
+   assert(testMap.size() == 1000);
+   assert(*testMap.find("7") == 7);
+   // insertion order is kept
+   assert(testMap.entryAt(0).first == "0");
+   assert(testMap.entryAt(999).first == "999");
+   for (int i = 0; i < 1000; i += 2) {
+      assert(testMap.erase(std::to_string(i)));
+   }
+   assert(!testMap.erase("0"));
+   assert(testMap.size() == 500);
+   for (int i = 0; i < 1000; i++) {
+      const int* found = testMap.find(std::to_string(i));
+      assert((found != nullptr) == (i % 2 == 1));
+      assert(found == nullptr || *found == i);
+   }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests a graph using hash maps for vertices and adjacency lists
+void testGraphInsertionOrder() {
+   std::cout << "Testing Graph with NeighborOrder::Insertion:" << std::endl;
+   Graph testGraph(NeighborOrder::Insertion);
+   assert(testGraph.add("A", "C", 2));
+   assert(testGraph.add("A", "B", 1));
+   assert(testGraph.add("C", "D", 4));
+   assert(!testGraph.add("A", "C", 9));
+   assert(!testGraph.add("B", "B", 9));
+   assert(testGraph.getNumVertices() == 4);
+   assert(testGraph.getNumEdges() == 3);
+   assert(testGraph.getEdgeWeight("A", "C") == 2);
+   assert(testGraph.getEdgeWeight("C", "D") == 4);
+   assert(testGraph.getEdgeWeight("D", "C") == INT_MAX);
+   assert(testGraph.getEdgeWeight("X", "C") == INT_MAX);
+   // neighbors come back in the order they were added
+   std::string order;
+   testGraph.breadthFirstTraversal("A", [&order](const std::string& label) {
+      order += label;
+   });
+   assert(order == "ACBD");
+   std::map<std::string, int> costs;
+   std::map<std::string, std::string> via;
+   testGraph.djikstraCostToAllVertices("A", costs, via);
+   assert(costs["D"] == 6 && via["D"] == "C");
+   assert(costs.count("A") == 0);
+   // a cycle back to the start lists the start with its cheapest cost,
+   // closed by the first vertex settled among equally cheap ones
+   assert(testGraph.add("D", "A", 5));
+   assert(testGraph.add("B", "A", 10));
+   for (int threads : {0, 2}) {
+      if (threads > 0) {
+         testGraph.setThreadPool(std::make_shared<ThreadPool>(threads));
+      }
+      testGraph.djikstraCostToAllVertices("A", costs, via);
+      assert(costs["A"] == 11 && via["A"] == "B");
+      ShortestPathResult result;
+      testGraph.djikstraCostToAllVertices("A", result);
+      assert(result.getCost("A") == 0);
+      assert(result.getPath("A") == std::vector<std::string> {"A"});
+      assert(result.getPath("D").size() == 3);
+   }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that addEdges gives the same graph as calling add in order
+void testGraphAddEdges() {
+   std::cout << "Testing Graph addEdges method:" << std::endl;
+   std::vector<EdgeRecord> batch;
+   for (int i = 0; i < 500; i++) {
+      batch.push_back({std::to_string(i % 37), std::to_string(i % 23), i});
+      batch.push_back({std::to_string(i % 11), std::to_string(i % 29), -i});
+   }
+   for (NeighborOrder order : {NeighborOrder::Alphabetical,
+                               NeighborOrder::Insertion}) {
+      for (int threads : {0, 4}) {
+         Graph oneByOne(order);
+         Graph batched(order);
+         if (threads > 0) {
+            batched.setThreadPool(std::make_shared<ThreadPool>(threads));
+         }
+         oneByOne.add("3", "5", 100);
+         batched.add("3", "5", 100);
+         int added = 0;
+         for (const auto& edge : batch) {
+            added += oneByOne.add(edge.start, edge.end, edge.edgeWeight);
+         }
+         assert(batched.addEdges(batch) == added);
+         assert(batched.getNumEdges() == oneByOne.getNumEdges());
+         assert(batched.getNumVertices() == oneByOne.getNumVertices());
+         assert(batched.getEdgeWeight("3", "5") == 100);
+         for (int v = 0; v < oneByOne.getNumVertices(); v++) {
+            assert(batched.getLabel(v) == oneByOne.getLabel(v));
+            std::string expected;
+            std::string got;
+            oneByOne.forEachNeighbor(v, [&](int endId, int edgeWeight) {
+               expected += oneByOne.getLabel(endId) + ":" +
+                           std::to_string(edgeWeight) + " ";
+               return true;
+            });
+            batched.forEachNeighbor(v, [&](int endId, int edgeWeight) {
+               got += batched.getLabel(endId) + ":" +
+                      std::to_string(edgeWeight) + " ";
+               return true;
+            });
+            assert(got == expected);
+         }
+      }
+   }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that a published version answers queries like Graph
+void testConcurrentGraphMatchesGraph() {
+   std::cout << "Testing ConcurrentGraph against Graph:" << std::endl;
+   Graph expected;
+   ConcurrentGraph testGraph;
+   for (int i = 0; i < 300; i++) {
+      std::string start = std::to_string(i * 7 % 41);
+      std::string end = std::to_string(i * 13 % 37);
+      assert(testGraph.add(start, end, i % 9 + 1) ==
+             expected.add(start, end, i % 9 + 1));
+   }
+   assert(testGraph.read()->getNumEdges() == 0);
+   assert(testGraph.publish() == 1);
+   auto version = testGraph.read();
+   assert(version->getNumVertices() == expected.getNumVertices());
+   assert(version->getNumEdges() == expected.getNumEdges());
+   assert(version->getEdgeWeight("7", "13") ==
+          expected.getEdgeWeight("7", "13"));
+   assert(version->getEdgeWeight("7", "99") == INT_MAX);
+   std::string got;
+   std::string want;
+   version->depthFirstTraversal("0", [&got](const std::string& label) {
+      got += label + " ";
+   });
+   expected.depthFirstTraversal("0", [&want](const std::string& label) {
+      want += label + " ";
+   });
+   assert(got == want);
+   got = want = "";
+   version->breadthFirstTraversal("0", [&got](const std::string& label) {
+      got += label + " ";
+   });
+   expected.breadthFirstTraversal("0", [&want](const std::string& label) {
+      want += label + " ";
+   });
+   assert(got == want);
+   std::map<std::string, int> gotWeight, wantWeight;
+   std::map<std::string, std::string> gotPrevious, wantPrevious;
+   version->djikstraCostToAllVertices("0", gotWeight, gotPrevious);
+   expected.djikstraCostToAllVertices("0", wantWeight, wantPrevious);
+   assert(gotWeight == wantWeight);
+   assert(gotPrevious == wantPrevious);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests readers running while a writer publishes new versions
+void testConcurrentGraphReaders() {
+   std::cout << "Testing ConcurrentGraph readers during writes:" << std::endl;
+   ConcurrentGraph testGraph;
+   testGraph.add("v0", "v1", 1);
+   testGraph.publish();
+   std::atomic<bool> done {false};
+   std::vector<std::thread> readers;
+   for (int r = 0; r < 4; r++) {
+      readers.emplace_back([&testGraph, &done] {
+         while (!done) {
+            // version n is the chain v0 -> ... -> vn
+            // plus an edge back to v0 from v1 ... vn-1
+            auto version = testGraph.read();
+            int visited = 0;
+            version->breadthFirstTraversal("v0", [&visited](const auto&) {
+               visited++;
+            });
+            assert(visited == version->getNumVertices());
+            assert(version->getNumEdges() == 2 * visited - 3);
+            assert(static_cast<int>(version->getVersion()) == visited - 1);
+         }
+      });
+   }
+   for (int i = 1; i < 300; i++) {
+      testGraph.add("v" + std::to_string(i), "v" + std::to_string(i + 1));
+      testGraph.add("v" + std::to_string(i), "v0");
+      testGraph.add("v" + std::to_string(i), "v" + std::to_string(i + 1));
+      testGraph.publish();
+   }
+   done = true;
+   for (auto& reader : readers) { reader.join(); }
+   // with no readers left, every old version can be freed
+   testGraph.reclaim();
+   assert(testGraph.getNumRetired() == 0);
+   // more readers at once than one block of slots holds
+   std::vector<ConcurrentGraph::ReadGuard> held;
+   for (int r = 0; r < 300; r++) { held.push_back(testGraph.read()); }
+   uint64_t pinned = held.front()->getVersion();
+   testGraph.add("v0", "v2");
+   assert(testGraph.publish() == pinned + 1);
+   assert(testGraph.getNumRetired() == 1);
+   for (const auto& version : held) {
+      assert(version->getVersion() == pinned);
+   }
+   held.clear();
+   testGraph.reclaim();
+   assert(testGraph.getNumRetired() == 0);
+   std::cout << "Passed test" << std::endl;
+}
+
+// all loopless path costs from v to end, by brute force
+void allPathCosts(const Graph& g, int v, int end, long long cost,
+                  std::vector<char>& onPath, std::vector<long long>& costs) {
+   if (v == end) {
+      costs.push_back(cost);
+      return;
+   }
+   onPath[v] = 1;
+   g.forEachNeighbor(v, [&](int u, int edgeWeight) {
+      if (!onPath[u]) {
+         allPathCosts(g, u, end, cost + edgeWeight, onPath, costs);
+      }
+      return true;
+   });
+   onPath[v] = 0;
+}
+
+// Tests Yen's k shortest paths against every path in a small graph
+void testKShortestPaths() {
+   std::cout << "Testing k shortest paths:" << std::endl;
+   Graph testGraph;
+   testGraph.add("A", "B", 1);
+   testGraph.add("A", "C", 2);
+   testGraph.add("B", "C", 1);
+   testGraph.add("B", "D", 4);
+   testGraph.add("C", "D", 1);
+   auto paths = kshortestpaths::yen(testGraph, "A", "D", 10);
+   assert(paths.size() == 3);
+   assert(paths[0].cost == 3);
+   assert(paths[1].cost == 3);
+   assert((paths[2].vertices == std::vector<std::string>{"A", "B", "D"}));
+   assert(paths[2].cost == 5);
+   assert(kshortestpaths::yen(testGraph, "D", "A", 3).empty());
+   // Compare with brute force on a denser graph
+   Graph dense;
+   for (int i = 0; i < 120; i++) {
+      dense.add(std::to_string(i * 5 % 9), std::to_string(i * 7 % 11),
+                i * 37 % 10);
+   }
+   int start = dense.findId("0");
+   int end = dense.findId("10");
+   std::vector<char> onPath(dense.getNumVertices(), 0);
+   std::vector<long long> costs;
+   allPathCosts(dense, start, end, 0, onPath, costs);
+   std::sort(costs.begin(), costs.end());
+   auto single = kshortestpaths::yen(dense, start, end, 40);
+   ThreadPool pool(4);
+   auto parallel = kshortestpaths::yen(dense, start, end, 40, &pool);
+   assert(single.size() == std::min<size_t>(40, costs.size()));
+   assert(parallel.size() == single.size());
+   for (size_t i = 0; i < single.size(); i++) {
+      assert(single[i].cost == costs[i]);
+      assert(parallel[i].vertices == single[i].vertices);
+   }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that the partitioner finds the one edge between two clusters
+void testPartitionGraph() {
+   std::cout << "Testing partitionGraph:" << std::endl;
+   Graph testGraph;
+   // two rings of 40 with chords, joined by a single edge
+   for (int i = 0; i < 40; i++) {
+      for (int j : {(i + 1) % 40, (i + 5) % 40, (i * 7 + 3) % 40}) {
+         testGraph.add("a" + std::to_string(i), "a" + std::to_string(j));
+         testGraph.add("b" + std::to_string(i), "b" + std::to_string(j));
+      }
+   }
+   testGraph.add("a0", "b0");
+   Partition split = partitionGraph(testGraph, 2);
+   assert(split.numShards == 2);
+   assert(split.cutEdges == 1);
+   int inFirst = 0;
+   for (int shard : split.shardOf) { inFirst += shard == 0; }
+   assert(inFirst == 40);
+   Partition four = partitionGraph(testGraph, 4);
+   std::vector<int> sizes(4, 0);
+   for (int shard : four.shardOf) { sizes[shard]++; }
+   for (int size : sizes) { assert(size <= 21); }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that sharded traversals match Graph
+void testShardedGraph() {
+   std::cout << "Testing ShardedGraph against Graph:" << std::endl;
+   Graph testGraph;
+   for (int i = 0; i < 400; i++) {
+      testGraph.add(std::to_string(i * 7 % 61), std::to_string(i * 11 % 57),
+                    i % 13 + 1);
+   }
+   ShardedGraph sharded(testGraph, 3);
+   assert(sharded.getNumVertices() == testGraph.getNumVertices());
+   for (std::string start : {"0", "5", "42"}) {
+      std::string got;
+      std::string want;
+      sharded.breadthFirstTraversal(start, [&got](const std::string& label) {
+         got += label + " ";
+      });
+      testGraph.breadthFirstTraversal(start,
+                                      [&want](const std::string& label) {
+         want += label + " ";
+      });
+      assert(got == want);
+      std::map<std::string, int> gotWeight, wantWeight;
+      std::map<std::string, std::string> gotPrevious, wantPrevious;
+      assert(sharded.djikstraCostToAllVertices(start, gotWeight,
+                                               gotPrevious));
+      testGraph.djikstraCostToAllVertices(start, wantWeight, wantPrevious);
+      assert(gotWeight == wantWeight);
+      assert(gotPrevious == wantPrevious);
+   }
+   // zero weight edges make many equally cheap predecessors; the one
+   // Dijkstra settles first must be picked
+   Graph zeroGraph;
+   for (int i = 0; i < 300; i++) {
+      zeroGraph.add(std::to_string(i * 7 % 41), std::to_string(i * 13 % 43),
+                    i % 3);
+   }
+   ShardedGraph zeroSharded(zeroGraph, 4);
+   for (std::string start : {"0", "7", "13"}) {
+      std::map<std::string, int> gotWeight, wantWeight;
+      std::map<std::string, std::string> gotPrevious, wantPrevious;
+      assert(zeroSharded.djikstraCostToAllVertices(start, gotWeight,
+                                                   gotPrevious));
+      zeroGraph.djikstraCostToAllVertices(start, wantWeight, wantPrevious);
+      assert(gotWeight == wantWeight);
+      assert(gotPrevious == wantPrevious);
+   }
+   // a negative cycle is reported instead of relaxing forever
+   Graph cycleGraph;
+   cycleGraph.add("A", "B", 1);
+   cycleGraph.add("B", "C", -3);
+   cycleGraph.add("C", "B", 1);
+   ShardedGraph cycleSharded(cycleGraph, 2);
+   std::map<std::string, int> cycleWeight;
+   std::map<std::string, std::string> cyclePrevious;
+   assert(!cycleSharded.djikstraCostToAllVertices("A", cycleWeight,
+                                                  cyclePrevious));
+   assert(cycleWeight.empty() && cyclePrevious.empty());
+   // negative weights with a cycle back to the start: the start's
+   // previous vertex closes that cycle, as in ExternalGraph
+   Graph negativeGraph;
+   negativeGraph.add("A", "B", 2);
+   negativeGraph.add("B", "C", -1);
+   negativeGraph.add("C", "A", 5);
+   negativeGraph.add("B", "D", 1);
+   for (bool longer : {false, true}) {
+      if (longer) { negativeGraph.add("D", "E", 1); }
+      const std::string path = "shardedtest.edges";
+      assert(ExternalGraph::writeFile(negativeGraph, path));
+      ExternalGraph external(path, 100);
+      ShardedGraph negativeSharded(negativeGraph, 2);
+      std::map<std::string, int> gotWeight, wantWeight;
+      std::map<std::string, std::string> gotPrevious, wantPrevious;
+      assert(negativeSharded.djikstraCostToAllVertices("A", gotWeight,
+                                                       gotPrevious));
+      assert(external.djikstraCostToAllVertices("A", wantWeight,
+                                                wantPrevious));
+      std::remove(path.c_str());
+      assert(gotWeight == wantWeight);
+      assert(gotPrevious == wantPrevious);
+      assert(gotWeight["A"] == 6 && gotPrevious["A"] == "C");
+   }
+   // stop early
+   int visited = 0;
+   sharded.breadthFirstTraversal("0", [&visited](const auto&) {
+      return ++visited < 5;
+   });
+   assert(visited == 5);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that parallelFor covers every item once, also when nested,
+// and that weighted slices split a heavy item
+void testThreadPool() {
+   std::cout << "Testing ThreadPool:" << std::endl;
+   ThreadPool pool(4);
+   assert(pool.getNumThreads() == 4);
+   assert(pool.currentWorker() == -1);
+   std::vector<std::atomic<int>> hits(10000);
+   pool.parallelFor(0, 100, 7, [&](long long first, long long last) {
+      assert(pool.currentWorker() >= 0);
+      for (long long i = first; i < last; i++) {
+         pool.parallelFor(i * 100, i * 100 + 100, 16,
+                          [&hits](long long b, long long e) {
+            for (long long j = b; j < e; j++) { hits[j]++; }
+         });
+      }
+   });
+   for (const auto& hit : hits) { assert(hit == 1); }
+   // one item with most of the weight is cut into grain-sized slices
+   std::vector<long long> prefix {0, 3, 3, 10003, 10010};
+   std::vector<std::atomic<int>> covered(10010);
+   std::atomic<int> slices {0};
+   pool.parallelForWeighted(prefix, 100, [&](long long item, long long from,
+                                             long long to) {
+      assert(item != 1);
+      assert(to - from <= 100);
+      slices++;
+      for (long long j = from; j < to; j++) { covered[prefix[item] + j]++; }
+   });
+   for (const auto& c : covered) { assert(c == 1); }
+   assert(slices >= 100);
+   uint64_t tasks = 0;
+   for (const auto& stats : pool.getStats()) {
+      tasks += stats.tasksRun;
+      assert(stats.utilization >= 0 && stats.utilization <= 1);
+   }
+   assert(tasks > 0);
+   pool.resetStats();
+   for (const auto& stats : pool.getStats()) { assert(stats.tasksRun == 0); }
+   // an exception in one piece comes out of parallelFor, also nested
+   for (bool nested : {false, true}) {
+      bool caught = false;
+      try {
+         pool.parallelFor(0, 64, 1, [&](long long first, long long) {
+            if (!nested && first == 40) { throw std::runtime_error("x"); }
+            if (nested && first == 40) {
+               pool.parallelFor(0, 8, 1, [](long long b, long long) {
+                  if (b == 5) { throw std::runtime_error("y"); }
+               });
+            }
+         });
+      } catch (const std::runtime_error& error) {
+         caught = std::string(error.what()) == (nested ? "y" : "x");
+      }
+      assert(caught);
+   }
+   // the pool still works afterwards
+   std::atomic<long long> sum {0};
+   pool.parallelFor(0, 1000, 10, [&sum](long long first, long long last) {
+      for (long long i = first; i < last; i++) { sum += i; }
+   });
+   assert(sum == 999 * 1000 / 2);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that a Graph with a thread pool gives the same results as without
+void testGraphThreadPool() {
+   std::cout << "Testing Graph with a thread pool:" << std::endl;
+   Graph serial;
+   Graph pooled;
+   pooled.setThreadPool(std::make_shared<ThreadPool>(4));
+   std::vector<EdgeRecord> batch;
+   // a hub with more neighbors than one task takes, and a tail behind it
+   for (int i = 0; i < 9000; i++) {
+      batch.push_back({"hub", "v" + std::to_string(i), i % 17 + 1});
+      batch.push_back({"v" + std::to_string(i),
+                       "v" + std::to_string(i * 31 % 9000), i % 5 + 1});
+   }
+   batch.push_back({"start", "hub", 2});
+   batch.push_back({"v4", "hub", 1});
+   serial.addEdges(batch);
+   pooled.addEdges(batch);
+   assert(pooled.getNumEdges() == serial.getNumEdges());
+   for (std::string start : {"start", "v17"}) {
+      std::string got;
+      std::string want;
+      serial.breadthFirstTraversal(start, [&want](const std::string& label) {
+         want += label + " ";
+      });
+      pooled.breadthFirstTraversal(start, [&got](const std::string& label) {
+         got += label + " ";
+      });
+      assert(got == want);
+      got.clear();
+      want.clear();
+      serial.depthFirstTraversal(start, [&want](const std::string& label) {
+         want += label + " ";
+      });
+      pooled.depthFirstTraversal(start, [&got](const std::string& label) {
+         got += label + " ";
+      });
+      assert(got == want);
+      std::map<std::string, int> gotWeight, wantWeight;
+      std::map<std::string, std::string> gotPrevious, wantPrevious;
+      serial.djikstraCostToAllVertices(start, wantWeight, wantPrevious);
+      pooled.djikstraCostToAllVertices(start, gotWeight, gotPrevious);
+      assert(gotWeight == wantWeight);
+      assert(gotPrevious == wantPrevious);
+   }
+   // pruning and stopping behave as without the pool
+   int visited = 0;
+   pooled.breadthFirstTraversal("start", [&visited](const auto& v) {
+      visited++;
+      return v.getLabel() == "hub" ? VisitAction::Prune
+                                   : VisitAction::Continue;
+   });
+   assert(visited == 2);
+   visited = 0;
+   pooled.breadthFirstTraversal("start", [&visited](const auto&) {
+      return ++visited < 5000;
+   });
+   assert(visited == 5000);
+   // the cached copy follows changes to the graph
+   auto before = pooled.getCsrView();
+   assert(before == pooled.getCsrView());
+   pooled.add("start", "new", 1);
+   assert(pooled.getCsrView()->getNumEdges() == before->getNumEdges() + 1);
+   // parsing on the pool reads the same edges
+   Graph file;
+   file.setThreadPool(pooled.getThreadPool());
+   file.readFile("graph1.txt");
+   Graph plainFile;
+   plainFile.readFile("graph1.txt");
+   assert(file.getNumEdges() == plainFile.getNumEdges());
+   for (int v = 0; v < plainFile.getNumVertices(); v++) {
+      assert(file.getLabel(v) == plainFile.getLabel(v));
+   }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests every supported relaxation kernel against a plain loop
+void testRelaxKernel() {
+   std::cout << "Testing relaxkernel:" << std::endl;
+   const int n = 1000;
+   std::vector<long long> cost(n);
+   std::vector<int> targets(n);
+   std::vector<int> weights(n);
+   for (int i = 0; i < n; i++) {
+      cost[i] = i % 7 == 0 ? shortestpath::kUnreachable : i * 13 % 401;
+      targets[i] = i * 37 % n;
+      weights[i] = i * 29 % 61 - 20;
+   }
+   relaxkernel::Kernel original = relaxkernel::getKernel();
+   for (auto kernel : {relaxkernel::Kernel::Scalar, relaxkernel::Kernel::Avx2,
+                       relaxkernel::Kernel::Avx512}) {
+      if (!relaxkernel::setKernel(kernel)) {
+         assert(!relaxkernel::isSupported(kernel));
+         continue;
+      }
+      // every length, so the vector loops and their tails are both used
+      for (int count = 0; count < 40; count++) {
+         for (long long base : {0LL, 150LL, 1000LL}) {
+            std::vector<int> improved(count);
+            int found = relaxkernel::relaxEdges(base, targets.data(),
+                                                weights.data(), count,
+                                                cost.data(), improved.data());
+            std::vector<int> expected;
+            for (int i = 0; i < count; i++) {
+               if (base + weights[i] < cost[targets[i]]) {
+                  expected.push_back(i);
+               }
+            }
+            improved.resize(found);
+            assert(improved == expected);
+         }
+      }
+   }
+   relaxkernel::setKernel(original);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests Dijkstra with zero weights and Bellman-Ford with negative ones
+void testBellmanFord() {
+   std::cout << "Testing Bellman-Ford and zero weight edges:" << std::endl;
+   Graph zero;
+   zero.add("A", "B", 0);
+   zero.add("A", "C", 5);
+   zero.add("C", "B", 1);
+   zero.add("B", "A", 0);
+   std::map<std::string, int> zeroWeight;
+   std::map<std::string, std::string> zeroPrevious;
+   zero.djikstraCostToAllVertices("A", zeroWeight, zeroPrevious);
+   // the zero weight cycle back to the start lists it too
+   assert(zeroWeight ==
+          (std::map<std::string, int> {{"A", 0}, {"B", 0}, {"C", 5}}));
+   assert(zeroPrevious["B"] == "A" && zeroPrevious["A"] == "B");
+
+   // non-negative weights shifted by a potential: cycles keep their
+   // cost, so there are negative edges but no negative cycles
+   Graph acyclicNegative;
+   auto potential = [](int v) { return v * 13 % 29; };
+   for (int i = 0; i < 300; i++) {
+      int v = i * 7 % 41;
+      int u = i * 11 % 43;
+      acyclicNegative.add(std::to_string(v), std::to_string(u),
+                          i * 17 % 23 + potential(v) - potential(u));
+   }
+   CsrGraph csr(acyclicNegative);
+   int n = csr.getNumVertices();
+   for (int start = 0; start < n; start += 5) {
+      std::vector<long long> cost;
+      std::vector<int> previous;
+      assert(shortestpath::bellmanFord(csr, start, cost, previous));
+      // plain Bellman-Ford: n - 1 rounds over every edge
+      std::vector<long long> expected(n, shortestpath::kUnreachable);
+      expected[start] = 0;
+      for (int round = 1; round < n; round++) {
+         for (int v = 0; v < n; v++) {
+            if (expected[v] == shortestpath::kUnreachable) { continue; }
+            csr.forEachNeighbor(v, [&](int u, int edgeWeight) {
+               expected[u] = std::min(expected[u], expected[v] + edgeWeight);
+               return true;
+            });
+         }
+      }
+      assert(cost == expected);
+      for (int v = 0; v < n; v++) {
+         if (v == start || cost[v] == shortestpath::kUnreachable) {
+            assert(previous[v] == -1 || v == start);
+            continue;
+         }
+         int p = previous[v];
+         assert(p != -1);
+         // getEdgeWeight cannot tell a weight of -1 from a missing edge
+         bool onEdge = false;
+         csr.forEachNeighbor(p, [&](int u, int edgeWeight) {
+            onEdge = onEdge || (u == v && cost[p] + edgeWeight == cost[v]);
+            return true;
+         });
+         assert(onEdge);
+      }
+   }
+   // a negative cycle reachable from the start is reported
+   Graph cycle;
+   cycle.add("A", "B", 1);
+   cycle.add("B", "C", -3);
+   cycle.add("C", "B", 1);
+   cycle.add("C", "D", 1);
+   std::vector<long long> cost;
+   std::vector<int> previous;
+   CsrGraph cycleCsr(cycle);
+   assert(!shortestpath::bellmanFord(cycleCsr, cycleCsr.findId("A"), cost,
+                                     previous));
+   assert(shortestpath::bellmanFord(cycleCsr, cycleCsr.findId("D"), cost,
+                                    previous));
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests Johnson's all-pairs costs against Bellman-Ford from each vertex
+void testJohnsonAllPairs() {
+   std::cout << "Testing Johnson all-pairs shortest paths:" << std::endl;
+   Graph testGraph;
+   auto potential = [](int v) { return v * 19 % 31; };
+   for (int i = 0; i < 400; i++) {
+      int v = i * 7 % 47;
+      int u = i * 13 % 53;
+      testGraph.add(std::to_string(v), std::to_string(u),
+                    i * 11 % 29 + potential(v) - potential(u));
+   }
+   CsrGraph csr(testGraph);
+   int n = csr.getNumVertices();
+   std::vector<std::vector<long long>> cost;
+   std::vector<std::vector<int>> previous;
+   assert(shortestpath::johnson(csr, cost, previous));
+   ThreadPool pool(4);
+   std::vector<std::vector<long long>> pooledCost;
+   std::vector<std::vector<int>> pooledPrevious;
+   assert(shortestpath::johnson(csr, pooledCost, pooledPrevious, &pool));
+   assert(pooledCost == cost);
+   for (int s = 0; s < n; s++) {
+      std::vector<long long> expected;
+      std::vector<int> unused;
+      assert(shortestpath::bellmanFord(csr, s, expected, unused));
+      assert(cost[s] == expected);
+   }
+   std::map<std::string, std::map<std::string, long long>> allPairs;
+   assert(testGraph.johnsonCostAllPairs(allPairs));
+   std::map<std::string, long long> fromZero;
+   std::map<std::string, std::string> previousFromZero;
+   assert(testGraph.bellmanFordCostToAllVertices("0", fromZero,
+                                                 previousFromZero));
+   // all pairs leaves a vertex itself out, even on a cycle
+   fromZero.erase("0");
+   assert(allPairs["0"] == fromZero);
+   // a negative cycle anywhere makes all-pairs fail
+   testGraph.add("1000", "1001", -5);
+   testGraph.add("1001", "1000", 4);
+   assert(!testGraph.johnsonCostAllPairs(allPairs));
+   assert(allPairs.empty());
+   assert(!testGraph.bellmanFordCostToAllVertices("1000", fromZero,
+                                                  previousFromZero));
+   assert(testGraph.bellmanFordCostToAllVertices("0", fromZero,
+                                                 previousFromZero));
+   // the start is listed with the cheapest cycle back to it, as
+   // djikstraCostToAllVertices lists it
+   Graph cycleGraph;
+   cycleGraph.add("A", "B", 2);
+   cycleGraph.add("B", "C", 1);
+   cycleGraph.add("C", "A", 5);
+   std::map<std::string, long long> cycleWeight, dijkstraWeight;
+   std::map<std::string, std::string> cyclePrevious, dijkstraPrevious;
+   assert(cycleGraph.bellmanFordCostToAllVertices("A", cycleWeight,
+                                                  cyclePrevious));
+   cycleGraph.djikstraCostToAllVertices("A", dijkstraWeight,
+                                        dijkstraPrevious);
+   assert(cycleWeight == dijkstraWeight);
+   assert(cyclePrevious == dijkstraPrevious);
+   assert(cycleWeight["A"] == 8 && cyclePrevious["A"] == "C");
+   Graph negativeGraph;
+   negativeGraph.add("A", "B", 2);
+   negativeGraph.add("B", "C", -1);
+   negativeGraph.add("C", "A", 5);
+   assert(negativeGraph.bellmanFordCostToAllVertices("A", cycleWeight,
+                                                     cyclePrevious));
+   assert(cycleWeight["A"] == 6 && cyclePrevious["A"] == "C");
+   // costs past INT_MAX need the 64-bit maps
+   Graph longPath;
+   longPath.add("A", "B", 2000000000);
+   longPath.add("B", "C", 2000000000);
+   std::map<std::string, long long> longWeight;
+   std::map<std::string, std::string> longPrevious;
+   longPath.djikstraCostToAllVertices("A", longWeight, longPrevious);
+   assert(longWeight["C"] == 4000000000LL);
+   assert(longPrevious["C"] == "B");
+   // the int maps leave out costs they cannot hold instead of wrapping
+   std::map<std::string, int> intWeight;
+   std::map<std::string, std::string> intPrevious;
+   longPath.djikstraCostToAllVertices("A", intWeight, intPrevious);
+   assert(intWeight.size() == 1 && intWeight["B"] == 2000000000);
+   assert(intPrevious.count("C") == 0);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that Stream VByte gives back what it was given, with each kernel
+void testStreamVByte() {
+   std::cout << "Testing streamvbyte:" << std::endl;
+   std::vector<uint32_t> values;
+   for (uint32_t i = 0; i < 1000; i++) {
+      // every byte length, in no particular pattern
+      values.push_back((i * 2654435761u) >> (i % 4 * 8));
+   }
+   std::vector<uint8_t> coded;
+   streamvbyte::encode(values.data(), values.size(), coded);
+   size_t numControls = streamvbyte::controlLength(values.size());
+   size_t numData = coded.size() - numControls;
+   assert(streamvbyte::dataLength(coded.data(), values.size()) == numData);
+   coded.resize(coded.size() + streamvbyte::kPadding, 0);
+   streamvbyte::Kernel original = streamvbyte::getKernel();
+   for (auto kernel : {streamvbyte::Kernel::Scalar,
+                       streamvbyte::Kernel::Ssse3}) {
+      if (!streamvbyte::setKernel(kernel)) { continue; }
+      for (size_t count : {size_t {0}, size_t {3}, size_t {8}, size_t {999},
+                           values.size()}) {
+         std::vector<uint32_t> decoded(count);
+         size_t read = streamvbyte::decode(coded.data(),
+                                           coded.data() + numControls, count,
+                                           decoded.data());
+         assert(read == streamvbyte::dataLength(coded.data(), count));
+         assert(std::equal(decoded.begin(), decoded.end(), values.begin()));
+         streamvbyte::decodeDelta(coded.data(), coded.data() + numControls,
+                                  count, 7, decoded.data());
+         uint32_t total = 7;
+         for (size_t i = 0; i < count; i++) {
+            total += values[i];
+            assert(decoded[i] == total);
+         }
+      }
+   }
+   streamvbyte::setKernel(original);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests that a CompressedGraph answers like the Graph it was made from
+void testCompressedGraph() {
+   std::cout << "Testing CompressedGraph against Graph:" << std::endl;
+   Graph testGraph;
+   Graph insertionGraph(NeighborOrder::Insertion);
+   // labels that sort like their numbers, edges mostly to nearby labels
+   auto label = [](int i) {
+      std::string digits = std::to_string(i);
+      return std::string(5 - digits.size(), '0') + digits;
+   };
+   for (int i = 0; i < 20000; i++) {
+      int from = i * 7919 % 5000;
+      int to = (from + i % 13 + 1 + (i % 97 == 0 ? 2000 : 0)) % 5000;
+      int edgeWeight = i % 29 - (i % 50 == 0 ? 40 : 0);
+      testGraph.add(label(from), label(to), edgeWeight);
+      insertionGraph.add(label(from), label(to), edgeWeight);
+   }
+   CompressedGraph compressed(testGraph);
+   assert(compressed.getNumVertices() == testGraph.getNumVertices());
+   assert(compressed.getNumEdges() == testGraph.getNumEdges());
+   for (int v = 0; v < compressed.getNumVertices(); v++) {
+      int source = testGraph.findId(compressed.getLabel(v));
+      std::string got;
+      std::string want;
+      compressed.forEachNeighbor(v, [&](int u, int edgeWeight) {
+         got += compressed.getLabel(u) + std::to_string(edgeWeight) + " ";
+         return true;
+      });
+      testGraph.forEachNeighbor(source, [&](int u, int edgeWeight) {
+         want += testGraph.getLabel(u) + std::to_string(edgeWeight) + " ";
+         return true;
+      });
+      assert(got == want);
+   }
+   // smaller than the flat arrays of a CsrGraph even at 4 edges a vertex,
+   // several times smaller when there are no weights to store
+   auto flatBytes = [](const CsrGraph& csr) {
+      return csr.getTargets().size() * sizeof(int) +
+             csr.getWeights().size() * sizeof(int) +
+             csr.getOffsets().size() * sizeof(long long);
+   };
+   assert(compressed.getAdjacencyBytes() * 3 <
+          flatBytes(CsrGraph(testGraph)) * 2);
+   Graph unweighted;
+   for (int i = 0; i < 20000; i++) {
+      unweighted.add(label(i % 1000), label((i % 1000 + i / 1000 + 1) % 1000));
+   }
+   CompressedGraph compressedUnweighted(unweighted);
+   assert(compressedUnweighted.getAdjacencyBytes() * 3 <
+          flatBytes(CsrGraph(unweighted)));
+   // a walk started inside another gets its own buffer, and a list
+   // without weights reads 0 after one with weights was decoded
+   for (int v = 0; v < 1000; v += 37) {
+      std::string plain;
+      std::string nested;
+      compressedUnweighted.forEachNeighbor(v, [&](int u, int edgeWeight) {
+         assert(edgeWeight == 0);
+         plain += std::to_string(u) + ":" + std::to_string(edgeWeight) + " ";
+         return true;
+      });
+      compressedUnweighted.forEachNeighbor(v, [&](int u, int edgeWeight) {
+         compressed.forEachNeighbor(u, [](int, int) { return true; });
+         nested += std::to_string(u) + ":" + std::to_string(edgeWeight) + " ";
+         return true;
+      });
+      assert(nested == plain);
+   }
+   // insertion order does not matter, lists are kept in label order
+   CompressedGraph fromInsertion(insertionGraph);
+   for (std::string start : {"00000", "01234", "04999"}) {
+      std::string got;
+      std::string want;
+      std::string other;
+      compressed.breadthFirstTraversal(start, [&got](const std::string& s) {
+         got += s + " ";
+      });
+      testGraph.breadthFirstTraversal(start, [&want](const std::string& s) {
+         want += s + " ";
+      });
+      fromInsertion.breadthFirstTraversal(start,
+                                          [&other](const std::string& s) {
+         other += s + " ";
+      });
+      assert(got == want);
+      assert(other == want);
+      got.clear();
+      want.clear();
+      compressed.depthFirstTraversal(start, [&got](const std::string& s) {
+         got += s + " ";
+      });
+      testGraph.depthFirstTraversal(start, [&want](const std::string& s) {
+         want += s + " ";
+      });
+      assert(got == want);
+   }
+   // Dijkstra needs weights that are not negative
+   Graph positive;
+   for (int i = 0; i < 3000; i++) {
+      positive.add(label(i * 31 % 700), label(i * 17 % 701), i % 23);
+   }
+   CompressedGraph compressedPositive(positive);
+   std::map<std::string, int> gotWeight, wantWeight;
+   std::map<std::string, std::string> gotPrevious, wantPrevious;
+   compressedPositive.djikstraCostToAllVertices("00000", gotWeight,
+                                                gotPrevious);
+   positive.djikstraCostToAllVertices("00000", wantWeight, wantPrevious);
+   assert(gotWeight == wantWeight);
+   assert(gotPrevious == wantPrevious);
+   assert(compressed.findId("99999") == -1);
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests the out-of-core graph against Graph, through edge files
+void testExternalGraph() {
+   std::cout << "Testing ExternalGraph against Graph:" << std::endl;
+   auto label = [](int i) {
+      std::string digits = std::to_string(i);
+      return std::string(4 - digits.size(), '0') + digits;
+   };
+   Graph testGraph;
+   for (int i = 0; i < 6000; i++) {
+      testGraph.add(label(i * 31 % 1500), label(i * 17 % 1501 + i % 3),
+                    i % 23 + 1);
+   }
+   const std::string path = "externaltest.edges";
+   assert(ExternalGraph::writeFile(testGraph, path));
+   // small batches so every pass reads the file in many pieces
+   ExternalGraph external(path, 1000);
+   assert(external.isOpen());
+   assert(external.getNumVertices() == testGraph.getNumVertices());
+   assert(external.getNumEdges() == testGraph.getNumEdges());
+   for (std::string start : {"0000", "0777", "1499"}) {
+      std::string got;
+      std::string want;
+      external.breadthFirstTraversal(start, [&got](const std::string& s) {
+         got += s + " ";
+      });
+      testGraph.breadthFirstTraversal(start, [&want](const std::string& s) {
+         want += s + " ";
+      });
+      assert(got == want);
+      // Stop works as in Graph
+      got.clear();
+      want.clear();
+      external.breadthFirstTraversal(start, [&got](const auto& v) {
+         got += v.getLabel() + " ";
+         return got.size() < 60;
+      });
+      testGraph.breadthFirstTraversal(start, [&want](const auto& v) {
+         want += v.getLabel() + " ";
+         return want.size() < 60;
+      });
+      assert(got == want);
+      std::map<std::string, int> gotWeight, wantWeight;
+      std::map<std::string, std::string> gotPrevious, wantPrevious;
+      assert(external.djikstraCostToAllVertices(start, gotWeight,
+                                                gotPrevious));
+      testGraph.djikstraCostToAllVertices(start, wantWeight, wantPrevious);
+      assert(gotWeight == wantWeight);
+      assert(gotPrevious == wantPrevious);
+   }
+   std::remove(path.c_str());
+
+   // zero weight edges make equally cheap predecessors; Dijkstra on the
+   // file picks the one Graph does, without passes over the whole file
+   Graph zeroGraph;
+   for (int i = 0; i < 2000; i++) {
+      zeroGraph.add(label(i * 7 % 300), label(i * 13 % 301), i % 3);
+   }
+   assert(ExternalGraph::writeFile(zeroGraph, path));
+   ExternalGraph externalZero(path, 100);
+   for (std::string start : {"0000", "0007", "0013"}) {
+      std::map<std::string, int> gotWeight, wantWeight;
+      std::map<std::string, std::string> gotPrevious, wantPrevious;
+      long long passes = externalZero.getNumPasses();
+      assert(externalZero.djikstraCostToAllVertices(start, gotWeight,
+                                                    gotPrevious));
+      assert(externalZero.getNumPasses() == passes);
+      zeroGraph.djikstraCostToAllVertices(start, wantWeight, wantPrevious);
+      assert(gotWeight == wantWeight);
+      assert(gotPrevious == wantPrevious);
+   }
+   std::remove(path.c_str());
+
+   // one pass per level: {A}, {B D}, {C}
+   Graph chain;
+   chain.add("A", "B", 1);
+   chain.add("B", "C", -2);
+   chain.add("A", "D", 4);
+   chain.add("D", "C", -6);
+   assert(ExternalGraph::writeFile(chain, path));
+   ExternalGraph externalChain(path);
+   long long passes = externalChain.getNumPasses();
+   std::string order;
+   externalChain.breadthFirstTraversal("A", [&order](const std::string& s) {
+      order += s;
+   });
+   assert(order == "ABDC");
+   assert(externalChain.getNumPasses() - passes == 3);
+   // negative weights are fine without a negative cycle
+   std::vector<long long> cost;
+   std::vector<int> previous;
+   assert(externalChain.costToAllVertices(externalChain.findId("A"), cost,
+                                          previous));
+   assert(cost[externalChain.findId("C")] == -2);
+   assert(externalChain.getLabel(previous[externalChain.findId("C")]) ==
+          "D");
+   std::remove(path.c_str());
+   Graph cycle;
+   cycle.add("A", "B", 1);
+   cycle.add("B", "C", -3);
+   cycle.add("C", "B", 1);
+   assert(ExternalGraph::writeFile(cycle, path));
+   ExternalGraph externalCycle(path);
+   assert(!externalCycle.costToAllVertices(0, cost, previous));
+   std::remove(path.c_str());
+
+   // a text graph file converted without building a Graph, holding
+   // only a few edges in memory at a time
+   assert(ExternalGraph::convertTextFile("graph2.txt", path, 5));
+   ExternalGraph converted(path);
+   Graph fromText;
+   fromText.readFile("graph2.txt");
+   assert(converted.getNumEdges() == fromText.getNumEdges());
+   std::string got;
+   std::string want;
+   converted.breadthFirstTraversal("A", [&got](const std::string& s) {
+      got += s;
+   });
+   fromText.breadthFirstTraversal("A", [&want](const std::string& s) {
+      want += s;
+   });
+   assert(got == want);
+   std::map<std::string, int> gotWeight, wantWeight;
+   std::map<std::string, std::string> gotPrevious, wantPrevious;
+   assert(converted.djikstraCostToAllVertices("O", gotWeight, gotPrevious));
+   fromText.djikstraCostToAllVertices("O", wantWeight, wantPrevious);
+   assert(gotWeight == wantWeight && gotPrevious == wantPrevious);
+   std::remove(path.c_str());
+   assert(!ExternalGraph(path).isOpen());
+   assert(!ExternalGraph::convertTextFile("missing.txt", path));
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests the three spanning forest algorithms against each other and a
+// plain O(n^2) Prim
+void testSpanningTree() {
+   std::cout << "Testing minimum spanning forests:" << std::endl;
+   Graph small;
+   small.add("A", "B", 4);
+   small.add("B", "A", 1);
+   small.add("B", "C", 2);
+   small.add("A", "C", 3);
+   small.add("D", "E", 7);
+   std::vector<EdgeRecord> edges;
+   assert(small.minimumSpanningForest(edges) == 1 + 2 + 7);
+   assert(edges.size() == 3);
+   assert(edges[0].start == "A" && edges[0].end == "B");
+   assert(edges[0].edgeWeight == 1);
+   // with the larger weight of A-B, A-C is cheaper
+   assert(small.minimumSpanningForest(edges, spanningtree::MergeRule::Max) ==
+          2 + 3 + 7);
+   assert(edges[1].start == "A" && edges[1].end == "C");
+   CsrGraph smallCsr(small);
+   assert(spanningtree::prim(smallCsr).numTrees == 2);
+
+   Graph testGraph;
+   for (int i = 0; i < 4000; i++) {
+      // repeated weights, both directions of some edges, and a few
+      // vertices off on their own
+      testGraph.add(std::to_string(i * 37 % 600),
+                    std::to_string(i * 53 % 590 + (i % 101 == 0 ? 700 : 0)),
+                    i % 17 - 3);
+   }
+   CsrGraph csr(testGraph);
+   int n = csr.getNumVertices();
+   ThreadPool pool(4);
+   auto same = [](const spanningtree::SpanningForest& a,
+                  const spanningtree::SpanningForest& b) {
+      if (a.edges.size() != b.edges.size()) { return false; }
+      for (size_t i = 0; i < a.edges.size(); i++) {
+         if (a.edges[i].start != b.edges[i].start ||
+             a.edges[i].end != b.edges[i].end ||
+             a.edges[i].weight != b.edges[i].weight) {
+            return false;
+         }
+      }
+      return a.totalWeight == b.totalWeight && a.numTrees == b.numTrees;
+   };
+   for (auto rule : {spanningtree::MergeRule::Min,
+                     spanningtree::MergeRule::Max}) {
+      auto byPrim = spanningtree::prim(csr, rule);
+      assert(same(byPrim, spanningtree::kruskal(csr, rule)));
+      assert(same(byPrim, spanningtree::boruvka(csr, rule)));
+      assert(same(byPrim, spanningtree::boruvka(csr, rule, &pool)));
+      // plain Prim over a weight matrix, tree by tree
+      std::vector<std::vector<long long>> matrix(
+         n, std::vector<long long>(n, LLONG_MAX));
+      for (int v = 0; v < n; v++) {
+         csr.forEachNeighbor(v, [&](int u, int edgeWeight) {
+            long long& w = matrix[std::min(u, v)][std::max(u, v)];
+            if (w == LLONG_MAX) {
+               w = edgeWeight;
+            } else if (rule == spanningtree::MergeRule::Min) {
+               w = std::min<long long>(w, edgeWeight);
+            } else {
+               w = std::max<long long>(w, edgeWeight);
+            }
+            return true;
+         });
+      }
+      std::vector<char> inTree(n, 0);
+      std::vector<long long> best(n, LLONG_MAX);
+      long long total = 0;
+      int numTrees = 0;
+      for (int step = 0; step < n; step++) {
+         int next = -1;
+         for (int v = 0; v < n; v++) {
+            if (!inTree[v] && (next == -1 || best[v] < best[next])) {
+               next = v;
+            }
+         }
+         if (best[next] == LLONG_MAX) {
+            numTrees++;
+         } else {
+            total += best[next];
+         }
+         inTree[next] = 1;
+         for (int u = 0; u < n; u++) {
+            long long w = matrix[std::min(u, next)][std::max(u, next)];
+            if (!inTree[u] && w < best[u]) { best[u] = w; }
+         }
+      }
+      assert(byPrim.totalWeight == total);
+      assert(byPrim.numTrees == numTrees);
+      assert(static_cast<int>(byPrim.edges.size()) == n - numTrees);
+   }
+   // Graph picks Boruvka with a thread pool, same forest
+   std::vector<EdgeRecord> withoutPool;
+   std::vector<EdgeRecord> withPool;
+   long long total = testGraph.minimumSpanningForest(withoutPool);
+   testGraph.setThreadPool(std::make_shared<ThreadPool>(2));
+   assert(testGraph.minimumSpanningForest(withPool) == total);
+   assert(withPool.size() == withoutPool.size());
+   for (size_t i = 0; i < withPool.size(); i++) {
+      assert(withPool[i].start == withoutPool[i].start);
+      assert(withPool[i].end == withoutPool[i].end);
+   }
+   std::cout << "Passed test" << std::endl;
+}
+
+// Tests shortest paths into a reusable flat result
+void testShortestPathResult() {
+   std::cout << "Testing ShortestPathResult:" << std::endl;
+   Graph testGraph;
+   for (int i = 0; i < 3000; i++) {
+      testGraph.add(std::to_string(i * 31 % 500), std::to_string(i * 17 % 503),
+                    i % 19 + 1);
+   }
+   ShortestPathResult result;
+   const long long* costData = nullptr;
+   const int* previousData = nullptr;
+   for (std::string start : {"0", "123", "499"}) {
+      testGraph.djikstraCostToAllVertices(start, result);
+      // the same arrays are filled again on later searches
+      if (costData != nullptr) {
+         assert(result.getCosts().data() == costData);
+         assert(result.getPreviousIds().data() == previousData);
+      }
+      costData = result.getCosts().data();
+      previousData = result.getPreviousIds().data();
+      std::map<std::string, int> weight, gotWeight;
+      std::map<std::string, std::string> previous, gotPrevious;
+      testGraph.djikstraCostToAllVertices(start, weight, previous);
+      result.toMaps(gotWeight, gotPrevious);
+      assert(gotWeight == weight);
+      assert(gotPrevious == previous);
+      assert(result.getStartId() == testGraph.findId(start));
+      assert(result.getCost(start) == 0);
+      for (const auto& [label, cost] : weight) {
+         // a cycle back to the start is listed but costs 0 to reach
+         if (label == start) { continue; }
+         assert(result.getCost(label) == cost);
+         std::vector<std::string> path = result.getPath(label);
+         assert(path.front() == start && path.back() == label);
+         // walking previous backwards gives the same path
+         std::string v = label;
+         for (size_t i = path.size() - 1; i > 0; i--) {
+            assert(path[i] == v);
+            v = previous[v];
+         }
+         assert(v == start);
+      }
+      for (int v = 0; v < result.getNumVertices(); v++) {
+         if (!result.isReachable(v)) {
+            assert(weight.count(result.getLabel(v)) == 0);
+            assert(result.getPathIds(v).empty());
+         }
+      }
+   }
+   assert(result.getCost("nowhere") == shortestpath::kUnreachable);
+   assert(result.getPath("nowhere").empty());
+   // an unknown start reaches nothing
+   testGraph.djikstraCostToAllVertices("nowhere", result);
+   assert(result.getStartId() == -1);
+   assert(result.getNumVertices() == testGraph.getNumVertices());
+   assert(!result.isReachable(0));
+   std::map<std::string, long long> none;
+   std::map<std::string, std::string> nonePrevious;
+   result.toMaps(none, nonePrevious);
+   assert(none.empty() && nonePrevious.empty());
+   // a result never searched has no vertices, so every ID is out of range
+   ShortestPathResult empty;
+   assert(empty.getNumVertices() == 0 && empty.getStartId() == -1);
+   assert(!empty.isReachable(0));
+   assert(empty.getCost(3) == shortestpath::kUnreachable);
+   assert(empty.getCost("A") == shortestpath::kUnreachable);
+   assert(empty.getPreviousId(0) == -1);
+   assert(empty.getPathIds(0).empty() && empty.getPath("A").empty());
+   empty.toMaps(none, nonePrevious);
+   assert(none.empty() && nonePrevious.empty());
    std::cout << "Passed test" << std::endl;
 }
 
@@ -341,6 +1625,8 @@ void testGraph2() {
 }
 
 int main() {
+   // shard workers for testShardedGraph are new runs of this program
+   ShardedGraph::runWorkerIfRequested();
    // My test functions
    testEdgeClass();
    testVertexConnect();
@@ -355,6 +1641,25 @@ int main() {
    testGraphAdd();
    testGraphGetEdgeWeight();
    testGraphReadFile();
+   testGraphLambdaVisitor();
+   testLabelHashMap();
+   testGraphInsertionOrder();
+   testGraphAddEdges();
+   testConcurrentGraphMatchesGraph();
+   testConcurrentGraphReaders();
+   testKShortestPaths();
+   testPartitionGraph();
+   testShardedGraph();
+   testThreadPool();
+   testGraphThreadPool();
+   testRelaxKernel();
+   testBellmanFord();
+   testJohnsonAllPairs();
+   testStreamVByte();
+   testCompressedGraph();
+   testExternalGraph();
+   testSpanningTree();
+   testShortestPathResult();
 
 // Provided
     testGraph0();
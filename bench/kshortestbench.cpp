@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../csrgraph.h"
+#include "../kshortestpaths.h"
+#include "../threadpool.h"
+
+/**
+ * Latency of kshortestpaths::yen on a road-like graph
+ *
+ *     kshortestbench [side] [queries] [k] [threads]
+ *
+ * The graph is a side x side grid, one million vertices by default, with
+ * an edge each way between neighbors and random weights from 1 to 100,
+ * copied into a CsrGraph. Each query asks for the k cheapest paths
+ * between two random vertices; the times printed cover yen only
+ *
+ *     g++ -std=c++17 -O2 -pthread bench/kshortestbench.cpp \
+ *         csrgraph.cpp threadpool.cpp -o kshortestbench
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** side x side grid as a graph view, weights fixed by a seeded hash */
+class GridView {
+ public:
+    explicit GridView(int side) : side(side), labels(side * side) {
+        for (int v = 0; v < side * side; v++) {
+            labels[v] = std::to_string(v / side) + "," +
+                        std::to_string(v % side);
+        }
+    }
+
+    int getNumVertices() const { return side * side; }
+
+    const std::string& getLabel(int id) const { return labels[id]; }
+
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const {
+        int row = id / side;
+        int col = id % side;
+        if (row > 0 && !f(id - side, weight(id, id - side))) { return false; }
+        if (col > 0 && !f(id - 1, weight(id, id - 1))) { return false; }
+        if (col + 1 < side && !f(id + 1, weight(id, id + 1))) { return false; }
+        if (row + 1 < side && !f(id + side, weight(id, id + side))) {
+            return false;
+        }
+        return true;
+    }
+
+ private:
+    /** weight of the edge from v to u, 1 to 100 */
+    static int weight(int v, int u) {
+        unsigned h = static_cast<unsigned>(v) * 2654435761u ^
+                     static_cast<unsigned>(u) * 40503u;
+        h ^= h >> 15;
+        h *= 2246822519u;
+        h ^= h >> 13;
+        return static_cast<int>(h % 100) + 1;
+    }
+
+    int side;
+    std::vector<std::string> labels;
+};
+
+/** milliseconds at the given fraction of sorted */
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) { return 0; }
+    return sorted[static_cast<size_t>(fraction * (sorted.size() - 1))];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int side = argc > 1 ? std::max(2, std::atoi(argv[1])) : 1000;
+    int queries = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+    int k = argc > 3 ? std::max(1, std::atoi(argv[3])) : 10;
+    int threads = argc > 4 ? std::max(0, std::atoi(argv[4])) : 0;
+
+    auto started = Clock::now();
+    CsrGraph graph((GridView(side)));
+    std::cout << graph.getNumVertices() << " vertices, "
+              << graph.getNumEdges() << " edges, built in "
+              << std::chrono::duration<double>(Clock::now() - started).count()
+              << " s" << std::endl;
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 0) { pool = std::make_unique<ThreadPool>(threads); }
+
+    std::mt19937 random(1);
+    std::vector<double> millis;
+    size_t paths = 0;
+    for (int q = 0; q < queries; q++) {
+        int start = static_cast<int>(random() % graph.getNumVertices());
+        int end = static_cast<int>(random() % graph.getNumVertices());
+        auto began = Clock::now();
+        auto found = kshortestpaths::yen(graph, start, end, k, pool.get());
+        millis.push_back(std::chrono::duration<double, std::milli>(
+            Clock::now() - began).count());
+        paths += found.size();
+    }
+    std::sort(millis.begin(), millis.end());
+    std::cout << queries << " queries, k = " << k << ", "
+              << (threads > 0 ? std::to_string(threads) + " threads"
+                              : std::string("no pool"))
+              << ", " << paths << " paths" << std::endl;
+    std::cout << "latency ms: p50 " << percentile(millis, 0.5) << ", p90 "
+              << percentile(millis, 0.9) << ", max " << millis.back()
+              << std::endl;
+    return 0;
+}
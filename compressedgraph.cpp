@@ -0,0 +1,108 @@
+#include "compressedgraph.h"
+#include "shortestpath.h"
+
+/**
+ * Read-only, compressed copy of a graph view
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+/** append value 7 bits at a time, low bits first */
+void writeVarint(uint32_t value, std::vector<uint8_t>& out) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+}  // namespace
+
+thread_local std::deque<CompressedGraph::DecodeBuffer>
+    CompressedGraph::decodeBuffers;
+thread_local size_t CompressedGraph::decodeDepth = 0;
+
+/** return number of vertices */
+int CompressedGraph::getNumVertices() const {
+    return static_cast<int>(labels.size());
+}
+
+/** return number of edges */
+long long CompressedGraph::getNumEdges() const {
+    return numEdges;
+}
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int CompressedGraph::findId(const std::string& vertexLabel) const {
+    auto it = std::lower_bound(labels.begin(), labels.end(), vertexLabel);
+    if (it == labels.end() || *it != vertexLabel) { return -1; }
+    return static_cast<int>(it - labels.begin());
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& CompressedGraph::getLabel(int id) const {
+    return labels[id];
+}
+
+/** return bytes used by the adjacency lists and their index */
+size_t CompressedGraph::getAdjacencyBytes() const {
+    return bytes.size() + offsets.size() * sizeof(uint64_t);
+}
+
+/** find the lowest cost from startLabel to all vertices that can be
+    reached, same output as Graph::djikstraCostToAllVertices */
+void CompressedGraph::djikstraCostToAllVertices(
+    const std::string& startLabel,
+    std::map<std::string, int>& weight,
+    std::map<std::string, std::string>& previous) const {
+    weight.clear();
+    previous.clear();
+    int startId = findId(startLabel);
+    if (startId != -1) {
+        shortestpath::dijkstra(*this, startId, weight, previous);
+    }
+}
+
+/** append the list of one vertex, targets sorted */
+void CompressedGraph::appendList(
+    const std::vector<std::pair<uint32_t, int>>& edges) {
+    bool hasWeights = false;
+    for (const auto& edge : edges) { hasWeights |= edge.second != 0; }
+    writeVarint(static_cast<uint32_t>(edges.size() * 2 + hasWeights), bytes);
+    if (edges.empty()) { return; }
+    std::vector<uint32_t> gaps;
+    std::vector<uint32_t> weights;
+    gaps.reserve(edges.size());
+    weights.reserve(edges.size());
+    uint32_t previous = 0;
+    for (const auto& [target, edgeWeight] : edges) {
+        gaps.push_back(target - previous);
+        previous = target;
+        weights.push_back((static_cast<uint32_t>(edgeWeight) << 1) ^
+                          static_cast<uint32_t>(edgeWeight >> 31));
+    }
+    std::vector<uint8_t> gapCode;
+    streamvbyte::encode(gaps.data(), gaps.size(), gapCode);
+    size_t gapBytes = gapCode.size() - streamvbyte::controlLength(gaps.size());
+    writeVarint(static_cast<uint32_t>(gapBytes), bytes);
+    bytes.insert(bytes.end(), gapCode.begin(), gapCode.end());
+    if (hasWeights) {
+        streamvbyte::encode(weights.data(), weights.size(), bytes);
+    }
+}
+
+/** read a varint at p and move p past it */
+uint32_t CompressedGraph::readVarint(const uint8_t*& p) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = *p++;
+        value |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if (b < 0x80) { return value; }
+    }
+}
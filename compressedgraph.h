@@ -0,0 +1,216 @@
+/**
+ * Read-only, compressed copy of a graph view (see traversal.h)
+ * Vertices are renumbered in label order, so a neighbor list sorted by
+ * label is also sorted by ID and can be stored as gaps between IDs,
+ * which are small when neighbors have similar labels. Gaps and weights
+ * are coded with Stream VByte (see streamvbyte.h) and decoded in chunks
+ * while a list is walked, with SIMD where the CPU has it
+ * Neighbors are visited in label order, as in a Graph built with
+ * NeighborOrder::Alphabetical, so traversals and shortest paths by label
+ * match that Graph. IDs are not the source view's IDs
+ *
+ * Each vertex's list is
+ *     varint degree * 2 + 1 if it has weights,
+ *     varint number of gap bytes, gap control bytes, gap bytes,
+ *     weight control bytes, weight bytes
+ * the weight part is left out when every weight in the list is 0, as in
+ * unweighted graphs; weights are zigzag coded so small negative weights
+ * stay small
+ */
+
+#ifndef COMPRESSEDGRAPH_H
+#define COMPRESSEDGRAPH_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "streamvbyte.h"
+#include "traversal.h"
+
+class CompressedGraph {
+ public:
+    /** compress graph; it can be changed or deleted afterwards */
+    template <typename GraphView>
+    explicit CompressedGraph(const GraphView& graph);
+
+    /** return number of vertices */
+    int getNumVertices() const;
+
+    /** return number of edges */
+    long long getNumEdges() const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist
+        IDs run from 0 to getNumVertices() - 1 in label order */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID */
+    const std::string& getLabel(int id) const;
+
+    /** return bytes used by the adjacency lists and their index,
+        labels not included */
+    size_t getAdjacencyBytes() const;
+
+    /** call f(endId, edgeWeight) for each neighbor of vertex id
+        in label order, stopping if f returns false
+        returns false if f stopped the walk */
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const;
+
+    /** depth-first traversal starting from startLabel, see traversal.h */
+    template <typename Visitor>
+    void depthFirstTraversal(const std::string& startLabel,
+                             Visitor&& visit) const;
+
+    /** breadth-first traversal starting from startLabel, see traversal.h */
+    template <typename Visitor>
+    void breadthFirstTraversal(const std::string& startLabel,
+                               Visitor&& visit) const;
+
+    /** find the lowest cost from startLabel to all vertices that can be
+        reached, same output as Graph::djikstraCostToAllVertices */
+    void djikstraCostToAllVertices(
+        const std::string& startLabel,
+        std::map<std::string, int>& weight,
+        std::map<std::string, std::string>& previous) const;
+
+ private:
+    /** values decoded at a time while walking a list */
+    static constexpr size_t kChunk = 128;
+
+    /** decoded targets, then weights, of one chunk */
+    using DecodeBuffer = std::array<uint32_t, 2 * kChunk>;
+
+    /** forEachNeighbor's buffers, one per walk in progress on this
+        thread; f may start another walk, as depth-first traversal does,
+        and the buffers are kept off the call stack so deep nesting does
+        not overflow it. A deque keeps outer walks' buffers in place
+        while more are added */
+    static thread_local std::deque<DecodeBuffer> decodeBuffers;
+
+    /** walks in progress on this thread */
+    static thread_local size_t decodeDepth;
+
+    /** append the list of one vertex, targets sorted */
+    void appendList(const std::vector<std::pair<uint32_t, int>>& edges);
+
+    /** read a varint at p and move p past it */
+    static uint32_t readVarint(const uint8_t*& p);
+
+    /** vertex labels by ID, sorted */
+    std::vector<std::string> labels;
+
+    /** where each vertex's list starts in bytes */
+    std::vector<uint64_t> offsets;
+
+    /** coded lists, followed by streamvbyte::kPadding zero bytes */
+    std::vector<uint8_t> bytes;
+
+    /** number of edges */
+    long long numEdges {0};
+};  // end CompressedGraph
+
+/** compress graph */
+template <typename GraphView>
+CompressedGraph::CompressedGraph(const GraphView& graph) {
+    int n = graph.getNumVertices();
+    // new ID of each source vertex is its place in label order
+    std::vector<int> order(n);
+    for (int v = 0; v < n; v++) { order[v] = v; }
+    std::sort(order.begin(), order.end(), [&graph](int a, int b) {
+        return graph.getLabel(a) < graph.getLabel(b);
+    });
+    std::vector<uint32_t> newId(n);
+    labels.reserve(n);
+    for (int i = 0; i < n; i++) {
+        newId[order[i]] = static_cast<uint32_t>(i);
+        labels.push_back(graph.getLabel(order[i]));
+    }
+    offsets.reserve(n + 1);
+    std::vector<std::pair<uint32_t, int>> edges;
+    for (int i = 0; i < n; i++) {
+        edges.clear();
+        graph.forEachNeighbor(order[i], [&](int endId, int edgeWeight) {
+            edges.emplace_back(newId[endId], edgeWeight);
+            return true;
+        });
+        std::sort(edges.begin(), edges.end());
+        offsets.push_back(bytes.size());
+        appendList(edges);
+        numEdges += static_cast<long long>(edges.size());
+    }
+    offsets.push_back(bytes.size());
+    bytes.resize(bytes.size() + streamvbyte::kPadding, 0);
+    bytes.shrink_to_fit();
+}
+
+/** call f(endId, edgeWeight) for each neighbor of vertex id */
+template <typename F>
+bool CompressedGraph::forEachNeighbor(int id, F&& f) const {
+    const uint8_t* p = bytes.data() + offsets[id];
+    size_t header = readVarint(p);
+    size_t degree = header >> 1;
+    bool hasWeights = (header & 1) != 0;
+    if (degree == 0) { return true; }
+    size_t gapBytes = readVarint(p);
+    const uint8_t* gapControls = p;
+    const uint8_t* gapData = gapControls + streamvbyte::controlLength(degree);
+    const uint8_t* weightControls = gapData + gapBytes;
+    const uint8_t* weightData =
+        weightControls + streamvbyte::controlLength(degree);
+    // leave the buffer to the next walk however this one ends
+    struct DepthGuard {
+        DepthGuard() { decodeDepth++; }
+        ~DepthGuard() { decodeDepth--; }
+    } guard;
+    if (decodeBuffers.size() < decodeDepth) { decodeBuffers.emplace_back(); }
+    uint32_t* targets = decodeBuffers[decodeDepth - 1].data();
+    uint32_t* weights = targets + kChunk;
+    if (!hasWeights) { std::fill(weights, weights + kChunk, 0); }
+    uint32_t previous = 0;
+    for (size_t first = 0; first < degree; first += kChunk) {
+        size_t count = std::min(kChunk, degree - first);
+        gapData += streamvbyte::decodeDelta(gapControls + first / 4, gapData,
+                                            count, previous, targets);
+        if (hasWeights) {
+            weightData += streamvbyte::decode(weightControls + first / 4,
+                                              weightData, count, weights);
+        }
+        previous = targets[count - 1];
+        for (size_t i = 0; i < count; i++) {
+            int edgeWeight = static_cast<int>(weights[i] >> 1) ^
+                             -static_cast<int>(weights[i] & 1);
+            if (!f(static_cast<int>(targets[i]), edgeWeight)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/** depth-first traversal starting from startLabel */
+template <typename Visitor>
+void CompressedGraph::depthFirstTraversal(const std::string& startLabel,
+                                          Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId != -1) {
+        traversal::depthFirst(*this, startId, visit);
+    }
+}
+
+/** breadth-first traversal starting from startLabel */
+template <typename Visitor>
+void CompressedGraph::breadthFirstTraversal(const std::string& startLabel,
+                                            Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId != -1) {
+        traversal::breadthFirst(*this, startId, visit);
+    }
+}
+
+#endif  // COMPRESSEDGRAPH_H
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <thread>
+
+#include "concurrentgraph.h"
+
+/**
+ * A graph that can be queried while it is being updated
+ * Readers pin an immutable GraphVersion, writers publish new ones
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+/** return number of vertices */
+int GraphVersion::getNumVertices() const {
+    return numberOfVertices;
+}
+
+/** return number of edges */
+int GraphVersion::getNumEdges() const {
+    return numberOfEdges;
+}
+
+/** return version number, increases by one per publish */
+uint64_t GraphVersion::getVersion() const {
+    return version;
+}
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int GraphVersion::findId(const std::string& vertexLabel) const {
+    size_t hash = LabelHashMap<int>::hashLabel(vertexLabel);
+    const int* id = indexShards[shardOf(hash)]->find(vertexLabel, hash);
+    return id == nullptr ? -1 : *id;
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& GraphVersion::getLabel(int id) const {
+    return labelChunks[id >> kChunkBits]->labels[id & (kChunkSize - 1)];
+}
+
+/** return weight of the edge between start and end
+    returns INT_MAX if not connected or vertices don't exist */
+int GraphVersion::getEdgeWeight(const std::string& start,
+                                const std::string& end) const {
+    int startId = findId(start);
+    int endId = findId(end);
+    if (startId == -1 || endId == -1) { return INT_MAX; }
+    const AdjacencyList* list = adjacencyOf(startId);
+    if (list == nullptr) { return INT_MAX; }
+    // targets are sorted by label
+    auto it = std::lower_bound(list->targets.begin(), list->targets.end(),
+                               end, [this](int target, const std::string& l) {
+        return getLabel(target) < l;
+    });
+    if (it == list->targets.end() || *it != endId) { return INT_MAX; }
+    return list->weights[it - list->targets.begin()];
+}
+
+/** find the lowest cost from startLabel to all vertices that can be
+    reached, same output as Graph::djikstraCostToAllVertices */
+void GraphVersion::djikstraCostToAllVertices(
+    const std::string& startLabel,
+    std::map<std::string, int>& weight,
+    std::map<std::string, std::string>& previous) const {
+    weight.clear();
+    previous.clear();
+    int startId = findId(startLabel);
+    if (startId != -1) {
+        shortestpath::dijkstra(*this, startId, weight, previous);
+    }
+}
+
+/** shard of the label index holding label */
+int GraphVersion::shardOf(size_t labelHash) {
+    // LabelHashMap probes with the low bits, shard on the high ones
+    return static_cast<int>(labelHash >> 56) & (kIndexShards - 1);
+}
+
+/** neighbors of id, nullptr if none */
+const GraphVersion::AdjacencyList* GraphVersion::adjacencyOf(int id) const {
+    return adjacencyChunks[id >> kChunkBits]->
+        lists[id & (kChunkSize - 1)].get();
+}
+
+/** pin a version in slot */
+ConcurrentGraph::ReadGuard::ReadGuard(ReaderSlot* slot,
+                                      const GraphVersion* pinned)
+    : slot(slot), pinned(pinned) {}
+
+/** take over other's slot */
+ConcurrentGraph::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : slot(other.slot), pinned(other.pinned) {
+    other.slot = nullptr;
+}
+
+/** release the slot so the version can be freed */
+ConcurrentGraph::ReadGuard::~ReadGuard() {
+    if (slot != nullptr) {
+        slot->epoch.store(0, std::memory_order_release);
+        slot->inUse.store(false, std::memory_order_release);
+    }
+}
+
+/** constructor, publishes an empty version 0 */
+ConcurrentGraph::ConcurrentGraph() {
+    auto* empty = new GraphVersion();
+    for (int i = 0; i < GraphVersion::kIndexShards; i++) {
+        empty->indexShards.push_back(std::make_shared<LabelHashMap<int>>());
+    }
+    current.store(empty);
+}
+
+/** destructor, frees every version */
+ConcurrentGraph::~ConcurrentGraph() {
+    delete current.load();
+    for (auto& [epoch, version] : retired) {
+        delete version;
+    }
+    ReaderBlock* block = readers.next.load();
+    while (block != nullptr) {
+        ReaderBlock* next = block->next.load();
+        delete block;
+        block = next;
+    }
+}
+
+/** pin the latest published version, never blocks */
+ConcurrentGraph::ReadGuard ConcurrentGraph::read() const {
+    // start looking at a different slot per thread to spread them out
+    size_t first = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    ReaderBlock* block = &readers;
+    while (true) {
+        for (size_t i = 0; i < kBlockSlots; i++) {
+            ReaderSlot& slot = block->slots[(first + i) % kBlockSlots];
+            bool expected = false;
+            if (!slot.inUse.load(std::memory_order_relaxed) &&
+                slot.inUse.compare_exchange_strong(
+                    expected, true, std::memory_order_acquire)) {
+                // announce the epoch before loading the version, so a
+                // writer that misses the announcement has replaced it
+                slot.epoch.store(globalEpoch.load());
+                return ReadGuard(&slot, current.load());
+            }
+        }
+        // every slot is taken: go on to the next block, adding one if
+        // this is the last, so a reader never waits for another
+        ReaderBlock* next = block->next.load();
+        if (next == nullptr) {
+            auto* grown = new ReaderBlock();
+            if (block->next.compare_exchange_strong(next, grown)) {
+                next = grown;
+            } else {
+                delete grown;
+            }
+        }
+        block = next;
+    }
+}
+
+/** stage a new edge, same rules as Graph::add */
+bool ConcurrentGraph::add(const std::string& start, const std::string& end,
+                          int edgeWeight) {
+    std::lock_guard<std::mutex> lock(writeLock);
+    return addLocked(start, end, edgeWeight);
+}
+
+/** stage a batch of edges, same as calling add on each in order */
+int ConcurrentGraph::addEdges(const std::vector<EdgeRecord>& edges) {
+    std::lock_guard<std::mutex> lock(writeLock);
+    int added = 0;
+    for (const auto& edge : edges) {
+        if (addLocked(edge.start, edge.end, edge.edgeWeight)) { added++; }
+    }
+    return added;
+}
+
+/** make staged edges visible to new readers and free old versions */
+uint64_t ConcurrentGraph::publish() {
+    std::lock_guard<std::mutex> lock(writeLock);
+    if (draft == nullptr) { return current.load()->getVersion(); }
+    uint64_t version = draft->version;
+    const GraphVersion* old = current.exchange(draft.release());
+    // readers that announced an epoch up to this one may still see old
+    retired.emplace_back(globalEpoch.fetch_add(1), old);
+    ownedLabelChunks.clear();
+    ownedAdjacencyChunks.clear();
+    ownedIndexShards.clear();
+    ownedLists.clear();
+    reclaimLocked();
+    return version;
+}
+
+/** free retired versions no reader can still see */
+int ConcurrentGraph::reclaim() {
+    std::lock_guard<std::mutex> lock(writeLock);
+    return reclaimLocked();
+}
+
+/** return the number of retired versions not yet freed */
+int ConcurrentGraph::getNumRetired() const {
+    std::lock_guard<std::mutex> lock(writeLock);
+    return static_cast<int>(retired.size());
+}
+
+/** stage a new edge, caller holds writeLock */
+bool ConcurrentGraph::addLocked(const std::string& start,
+                                const std::string& end, int edgeWeight) {
+    if (start == end) { return false; }
+    ensureDraft();
+    int startId = findOrCreateVertex(start);
+    int endId = findOrCreateVertex(end);
+    auto byLabel = [this](int target, const std::string& label) {
+        return draft->getLabel(target) < label;
+    };
+    // look before copying, so rejected edges copy nothing
+    const GraphVersion::AdjacencyList* shared = draft->adjacencyOf(startId);
+    if (shared != nullptr) {
+        auto it = std::lower_bound(shared->targets.begin(),
+                                   shared->targets.end(), end, byLabel);
+        if (it != shared->targets.end() && *it == endId) { return false; }
+    }
+    GraphVersion::AdjacencyList& list = mutableAdjacency(startId);
+    auto it = std::lower_bound(list.targets.begin(), list.targets.end(),
+                               end, byLabel);
+    size_t pos = it - list.targets.begin();
+    list.targets.insert(it, endId);
+    list.weights.insert(list.weights.begin() + pos, edgeWeight);
+    draft->numberOfEdges++;
+    return true;
+}
+
+/** start a draft version from the current one if there is none */
+void ConcurrentGraph::ensureDraft() {
+    if (draft != nullptr) { return; }
+    // copies only the chunk and shard pointers
+    draft = std::make_unique<GraphVersion>(*current.load());
+    draft->version++;
+    ownedLabelChunks.assign(draft->labelChunks.size(), 0);
+    ownedAdjacencyChunks.assign(draft->adjacencyChunks.size(), 0);
+    ownedIndexShards.assign(GraphVersion::kIndexShards, 0);
+    ownedLists.clear();
+}
+
+/** find a vertex in the draft, create it if it does not exist */
+int ConcurrentGraph::findOrCreateVertex(const std::string& vertexLabel) {
+    size_t hash = LabelHashMap<int>::hashLabel(vertexLabel);
+    int shard = GraphVersion::shardOf(hash);
+    const int* found = draft->indexShards[shard]->find(vertexLabel, hash);
+    if (found != nullptr) { return *found; }
+    int id = draft->numberOfVertices++;
+    if (ownedIndexShards[shard] == 0) {
+        draft->indexShards[shard] = std::make_shared<LabelHashMap<int>>(
+            *draft->indexShards[shard]);
+        ownedIndexShards[shard] = 1;
+    }
+    draft->indexShards[shard]->insert(vertexLabel, hash, id);
+    size_t chunk = id >> GraphVersion::kChunkBits;
+    if (chunk == draft->labelChunks.size()) {
+        draft->labelChunks.push_back(
+            std::make_shared<GraphVersion::LabelChunk>());
+        draft->adjacencyChunks.push_back(
+            std::make_shared<GraphVersion::AdjacencyChunk>());
+        ownedLabelChunks.push_back(1);
+        ownedAdjacencyChunks.push_back(1);
+    }
+    if (ownedLabelChunks[chunk] == 0) {
+        draft->labelChunks[chunk] = std::make_shared<GraphVersion::LabelChunk>(
+            *draft->labelChunks[chunk]);
+        ownedLabelChunks[chunk] = 1;
+    }
+    if (ownedAdjacencyChunks[chunk] == 0) {
+        draft->adjacencyChunks[chunk] =
+            std::make_shared<GraphVersion::AdjacencyChunk>(
+                *draft->adjacencyChunks[chunk]);
+        ownedAdjacencyChunks[chunk] = 1;
+    }
+    draft->labelChunks[chunk]->labels.push_back(vertexLabel);
+    draft->adjacencyChunks[chunk]->lists.push_back(nullptr);
+    return id;
+}
+
+/** adjacency list of id in the draft, copied first if shared */
+GraphVersion::AdjacencyList& ConcurrentGraph::mutableAdjacency(int id) {
+    size_t chunk = id >> GraphVersion::kChunkBits;
+    if (ownedAdjacencyChunks[chunk] == 0) {
+        draft->adjacencyChunks[chunk] =
+            std::make_shared<GraphVersion::AdjacencyChunk>(
+                *draft->adjacencyChunks[chunk]);
+        ownedAdjacencyChunks[chunk] = 1;
+    }
+    auto& list = draft->adjacencyChunks[chunk]->
+        lists[id & (GraphVersion::kChunkSize - 1)];
+    if (ownedLists.insert(id).second) {
+        list = list == nullptr
+               ? std::make_shared<GraphVersion::AdjacencyList>()
+               : std::make_shared<GraphVersion::AdjacencyList>(*list);
+    }
+    return *list;
+}
+
+/** free retired versions, caller holds writeLock */
+int ConcurrentGraph::reclaimLocked() {
+    // oldest epoch any reader announced, readers announcing later
+    // load a version that has not been retired
+    uint64_t oldest = UINT64_MAX;
+    for (const ReaderBlock* block = &readers; block != nullptr;
+         block = block->next.load()) {
+        for (const auto& slot : block->slots) {
+            uint64_t epoch = slot.epoch.load();
+            if (epoch != 0) { oldest = std::min(oldest, epoch); }
+        }
+    }
+    int freed = 0;
+    size_t kept = 0;
+    for (auto& [epoch, version] : retired) {
+        if (epoch < oldest) {
+            delete version;
+            freed++;
+        } else {
+            retired[kept++] = {epoch, version};
+        }
+    }
+    retired.resize(kept);
+    return freed;
+}
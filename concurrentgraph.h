@@ -0,0 +1,283 @@
+/**
+ * A graph that can be queried while it is being updated
+ * Readers pin the current GraphVersion without taking a lock and see a
+ * consistent, immutable graph until they let go of it
+ * A writer stages edges with add/addEdges and makes them visible with
+ * publish. Versions share everything the writer did not touch: vertices
+ * are kept in chunks of 1024 and the label index in 256 shards, and only
+ * the chunks, shards and adjacency lists that change are copied
+ * Old versions are freed once no reader can still be looking at them,
+ * using epoch-based reclamation
+ */
+
+#ifndef CONCURRENTGRAPH_H
+#define CONCURRENTGRAPH_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "labelhashmap.h"
+#include "shortestpath.h"
+#include "traversal.h"
+
+/** immutable snapshot of a ConcurrentGraph
+    has the same queries as Graph, neighbors in alphabetical order */
+class GraphVersion {
+ public:
+    /** return number of vertices */
+    int getNumVertices() const;
+
+    /** return number of edges */
+    int getNumEdges() const;
+
+    /** return version number, increases by one per publish */
+    uint64_t getVersion() const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID */
+    const std::string& getLabel(int id) const;
+
+    /** return weight of the edge between start and end
+        returns INT_MAX if not connected or vertices don't exist */
+    int getEdgeWeight(const std::string& start, const std::string& end) const;
+
+    /** call f(endId, edgeWeight) for each neighbor of vertex id
+        in alphabetical order, stopping if f returns false */
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const;
+
+    /** depth-first traversal starting from startLabel, see traversal.h */
+    template <typename Visitor>
+    void depthFirstTraversal(const std::string& startLabel,
+                             Visitor&& visit) const;
+
+    /** breadth-first traversal starting from startLabel, see traversal.h */
+    template <typename Visitor>
+    void breadthFirstTraversal(const std::string& startLabel,
+                               Visitor&& visit) const;
+
+    /** find the lowest cost from startLabel to all vertices that can be
+        reached, same output as Graph::djikstraCostToAllVertices */
+    void djikstraCostToAllVertices(
+        const std::string& startLabel,
+        std::map<std::string, int>& weight,
+        std::map<std::string, std::string>& previous) const;
+
+ private:
+    friend class ConcurrentGraph;
+
+    /** vertices per chunk */
+    static constexpr int kChunkBits = 10;
+    static constexpr int kChunkSize = 1 << kChunkBits;
+
+    /** shards in the label index */
+    static constexpr int kIndexShards = 256;
+
+    /** neighbors of one vertex, sorted by label */
+    struct AdjacencyList {
+        std::vector<int> targets;
+        std::vector<int> weights;
+    };
+
+    /** labels of kChunkSize consecutive vertices */
+    struct LabelChunk {
+        std::vector<std::string> labels;
+    };
+
+    /** adjacency lists of kChunkSize consecutive vertices
+        nullptr for a vertex with no neighbors */
+    struct AdjacencyChunk {
+        std::vector<std::shared_ptr<AdjacencyList>> lists;
+    };
+
+    /** shard of the label index holding label */
+    static int shardOf(size_t labelHash);
+
+    /** neighbors of id, nullptr if none */
+    const AdjacencyList* adjacencyOf(int id) const;
+
+    /** version number */
+    uint64_t version {0};
+
+    /** number of vertices */
+    int numberOfVertices {0};
+
+    /** number of edges */
+    int numberOfEdges {0};
+
+    /** vertex labels by ID */
+    std::vector<std::shared_ptr<LabelChunk>> labelChunks;
+
+    /** adjacency lists by vertex ID */
+    std::vector<std::shared_ptr<AdjacencyChunk>> adjacencyChunks;
+
+    /** label to ID */
+    std::vector<std::shared_ptr<LabelHashMap<int>>> indexShards;
+};  // end GraphVersion
+
+class ConcurrentGraph {
+    struct ReaderSlot;
+
+ public:
+    /** keeps a version alive while a reader uses it, releases it when
+        destroyed; readers must not keep one across a long pause */
+    class ReadGuard {
+     public:
+        ReadGuard(ReadGuard&& other) noexcept;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard();
+
+        /** the pinned version */
+        const GraphVersion& operator*() const { return *pinned; }
+        const GraphVersion* operator->() const { return pinned; }
+
+     private:
+        friend class ConcurrentGraph;
+        ReadGuard(ReaderSlot* slot, const GraphVersion* pinned);
+
+        /** reader slot we hold, nullptr once moved from */
+        ReaderSlot* slot;
+
+        /** version being read */
+        const GraphVersion* pinned;
+    };  // end ReadGuard
+
+    /** constructor, publishes an empty version 0 */
+    ConcurrentGraph();
+
+    /** destructor, frees every version
+        no ReadGuard may outlive the graph */
+    ~ConcurrentGraph();
+
+    ConcurrentGraph(const ConcurrentGraph&) = delete;
+    ConcurrentGraph& operator=(const ConcurrentGraph&) = delete;
+
+    /** pin the latest published version, never blocks on writers
+        or other readers; any number of readers can hold a version */
+    ReadGuard read() const;
+
+    /** stage a new edge, same rules as Graph::add
+        not visible to readers until publish */
+    bool add(const std::string& start, const std::string& end,
+             int edgeWeight = 0);
+
+    /** stage a batch of edges, same as calling add on each in order
+        returns the number of edges added */
+    int addEdges(const std::vector<EdgeRecord>& edges);
+
+    /** make staged edges visible to new readers and free old versions
+        nobody is reading; returns the new version number */
+    uint64_t publish();
+
+    /** free retired versions no reader can still see
+        returns the number freed */
+    int reclaim();
+
+    /** return the number of retired versions not yet freed */
+    int getNumRetired() const;
+
+ private:
+    /** reader slots per block */
+    static constexpr int kBlockSlots = 128;
+
+    /** reader slot, on its own cache line */
+    struct alignas(64) ReaderSlot {
+        std::atomic<bool> inUse {false};
+        /** epoch the reader started in, 0 while not reading */
+        std::atomic<uint64_t> epoch {0};
+    };
+
+    /** reader slots, more blocks are chained on when all are taken and
+        stay until the graph is destroyed */
+    struct ReaderBlock {
+        ReaderSlot slots[kBlockSlots];
+        std::atomic<ReaderBlock*> next {nullptr};
+    };
+
+    /** stage a new edge, caller holds writeLock */
+    bool addLocked(const std::string& start, const std::string& end,
+                   int edgeWeight);
+
+    /** start a draft version from the current one if there is none */
+    void ensureDraft();
+
+    /** find a vertex in the draft, create it if it does not exist */
+    int findOrCreateVertex(const std::string& vertexLabel);
+
+    /** adjacency list of id in the draft, copied first if shared */
+    GraphVersion::AdjacencyList& mutableAdjacency(int id);
+
+    /** free retired versions, caller holds writeLock */
+    int reclaimLocked();
+
+    /** latest published version */
+    std::atomic<const GraphVersion*> current;
+
+    /** incremented on every publish */
+    mutable std::atomic<uint64_t> globalEpoch {1};
+
+    /** first block of reader slots */
+    mutable ReaderBlock readers;
+
+    /** serializes writers, readers never take it */
+    mutable std::mutex writeLock;
+
+    /** version being built by the writer, nullptr if nothing staged */
+    std::unique_ptr<GraphVersion> draft;
+
+    /** chunks and shards of draft not shared with any published version */
+    std::vector<char> ownedLabelChunks;
+    std::vector<char> ownedAdjacencyChunks;
+    std::vector<char> ownedIndexShards;
+
+    /** vertices whose adjacency list in draft is not shared */
+    std::unordered_set<int> ownedLists;
+
+    /** replaced versions and the epoch they were retired in */
+    std::vector<std::pair<uint64_t, const GraphVersion*>> retired;
+};  // end ConcurrentGraph
+
+/** call f(endId, edgeWeight) for each neighbor of vertex id */
+template <typename F>
+bool GraphVersion::forEachNeighbor(int id, F&& f) const {
+    const AdjacencyList* list = adjacencyOf(id);
+    if (list == nullptr) { return true; }
+    for (size_t i = 0; i < list->targets.size(); i++) {
+        if (!f(list->targets[i], list->weights[i])) { return false; }
+    }
+    return true;
+}
+
+/** depth-first traversal starting from startLabel */
+template <typename Visitor>
+void GraphVersion::depthFirstTraversal(const std::string& startLabel,
+                                       Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId != -1) {
+        traversal::depthFirst(*this, startId, visit);
+    }
+}
+
+/** breadth-first traversal starting from startLabel */
+template <typename Visitor>
+void GraphVersion::breadthFirstTraversal(const std::string& startLabel,
+                                         Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId != -1) {
+        traversal::breadthFirst(*this, startId, visit);
+    }
+}
+
+#endif  // CONCURRENTGRAPH_H
@@ -0,0 +1,38 @@
+/**
+ * Run-time check for the instruction set extensions the SIMD kernels of
+ * relaxkernel and streamvbyte use, so they pick a kernel the same way
+ * Off x86-64, or with a compiler without the CPU builtins, no extension
+ * is reported and only the scalar kernels are used
+ */
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+namespace cpufeatures {
+
+/** extensions a kernel can need */
+enum class Feature { Ssse3, Avx2, Avx512f };
+
+/** return true if this CPU has feature
+    safe to call during static initialization */
+inline bool has(Feature feature) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // kernels are picked during static initialization, possibly before
+    // libgcc has filled in the CPU features itself
+    __builtin_cpu_init();
+    switch (feature) {
+        case Feature::Ssse3:
+            return __builtin_cpu_supports("ssse3");
+        case Feature::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case Feature::Avx512f:
+            return __builtin_cpu_supports("avx512f");
+    }
+#endif
+    static_cast<void>(feature);
+    return false;
+}
+
+}  // namespace cpufeatures
+
+#endif  // CPUFEATURES_H
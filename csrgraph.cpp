@@ -0,0 +1,52 @@
+#include "csrgraph.h"
+
+/**
+ * Read-only copy of a graph view in compressed sparse row form
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+/** return number of vertices */
+int CsrGraph::getNumVertices() const {
+    return static_cast<int>(labels.size());
+}
+
+/** return number of edges */
+long long CsrGraph::getNumEdges() const {
+    return static_cast<long long>(targets.size());
+}
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int CsrGraph::findId(const std::string& vertexLabel) const {
+    const int* found = index.find(vertexLabel);
+    return found == nullptr ? -1 : *found;
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& CsrGraph::getLabel(int id) const {
+    return labels[id];
+}
+
+/** return number of neighbors of vertex id */
+long long CsrGraph::getDegree(int id) const {
+    return offsets[id + 1] - offsets[id];
+}
+
+/** start of each vertex's neighbors, getNumVertices() + 1 entries */
+const std::vector<long long>& CsrGraph::getOffsets() const {
+    return offsets;
+}
+
+/** neighbor IDs of all vertices, one list after the other */
+const std::vector<int>& CsrGraph::getTargets() const {
+    return targets;
+}
+
+/** edge weights matching getTargets */
+const std::vector<int>& CsrGraph::getWeights() const {
+    return weights;
+}
@@ -0,0 +1,128 @@
+/**
+ * Read-only copy of a graph view (see traversal.h) in compressed sparse
+ * row form: the neighbors of vertex v are targets[offsets[v]] up to
+ * targets[offsets[v + 1]], in the view's neighbor order, with matching
+ * weights. IDs and labels are the ones the view used
+ * The flat arrays let the parallel algorithms hand out slices of one
+ * vertex's neighbor list to different threads
+ */
+
+#ifndef CSRGRAPH_H
+#define CSRGRAPH_H
+
+#include <string>
+#include <vector>
+
+#include "labelhashmap.h"
+#include "threadpool.h"
+
+class CsrGraph {
+ public:
+    /** copy graph, counting and filling adjacency lists on pool if given */
+    template <typename GraphView>
+    explicit CsrGraph(const GraphView& graph, ThreadPool* pool = nullptr);
+
+    /** return number of vertices */
+    int getNumVertices() const;
+
+    /** return number of edges */
+    long long getNumEdges() const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID */
+    const std::string& getLabel(int id) const;
+
+    /** return number of neighbors of vertex id */
+    long long getDegree(int id) const;
+
+    /** start of each vertex's neighbors, getNumVertices() + 1 entries */
+    const std::vector<long long>& getOffsets() const;
+
+    /** neighbor IDs of all vertices, one list after the other */
+    const std::vector<int>& getTargets() const;
+
+    /** edge weights matching getTargets */
+    const std::vector<int>& getWeights() const;
+
+    /** call f(endId, edgeWeight) for each neighbor of vertex id
+        stopping if f returns false
+        returns false if f stopped the walk */
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const;
+
+ private:
+    /** vertex labels by ID */
+    std::vector<std::string> labels;
+
+    /** label to ID */
+    LabelHashMap<int> index;
+
+    /** start of each vertex's neighbors in targets */
+    std::vector<long long> offsets;
+
+    /** neighbor IDs */
+    std::vector<int> targets;
+
+    /** edge weights */
+    std::vector<int> weights;
+};  // end CsrGraph
+
+/** copy graph, counting and filling adjacency lists on pool if given */
+template <typename GraphView>
+CsrGraph::CsrGraph(const GraphView& graph, ThreadPool* pool) {
+    int n = graph.getNumVertices();
+    labels.reserve(n);
+    index.reserve(n);
+    for (int v = 0; v < n; v++) {
+        labels.push_back(graph.getLabel(v));
+        index.insert(labels.back(), v);
+    }
+    // vertices are independent, so both passes can be split over threads
+    auto forVertices = [pool, n](auto&& body) {
+        const long long grain = 1024;
+        if (pool == nullptr) {
+            body(0, n);
+        } else {
+            pool->parallelFor(0, n, grain, body);
+        }
+    };
+    offsets.assign(n + 1, 0);
+    forVertices([&](long long first, long long last) {
+        for (long long v = first; v < last; v++) {
+            long long degree = 0;
+            graph.forEachNeighbor(static_cast<int>(v), [&degree](int, int) {
+                degree++;
+                return true;
+            });
+            offsets[v + 1] = degree;
+        }
+    });
+    for (int v = 0; v < n; v++) { offsets[v + 1] += offsets[v]; }
+    targets.resize(offsets[n]);
+    weights.resize(offsets[n]);
+    forVertices([&](long long first, long long last) {
+        for (long long v = first; v < last; v++) {
+            long long slot = offsets[v];
+            graph.forEachNeighbor(static_cast<int>(v),
+                                  [&](int endId, int edgeWeight) {
+                targets[slot] = endId;
+                weights[slot] = edgeWeight;
+                slot++;
+                return true;
+            });
+        }
+    });
+}
+
+/** call f(endId, edgeWeight) for each neighbor of vertex id */
+template <typename F>
+bool CsrGraph::forEachNeighbor(int id, F&& f) const {
+    for (long long i = offsets[id]; i < offsets[id + 1]; i++) {
+        if (!f(targets[i], weights[i])) { return false; }
+    }
+    return true;
+}
+
+#endif  // CSRGRAPH_H
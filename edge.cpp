@@ -16,6 +16,13 @@ Edge::Edge(const std::string& end, int weight) {
    edgeWeight = weight;
 }
 
+/** constructor with label, weight and the graph ID of the end vertex */
+Edge::Edge(const std::string& end, int weight, int endId) {
+   endVertex = end;
+   edgeWeight = weight;
+   endVertexId = endId;
+}
+
 /** return the vertex this edge connects to */
 std::string Edge::getEndVertex() const { 
    return endVertex; 
@@ -25,3 +32,8 @@ std::string Edge::getEndVertex() const {
 int Edge::getWeight() const { 
    return edgeWeight;
 }
+
+/** return the graph ID of the end vertex, -1 if not known */
+int Edge::getEndId() const {
+   return endVertexId;
+}
@@ -17,18 +17,27 @@ class Edge {
     /** constructor with label and weight */
     Edge(const std::string& end, int weight);
 
+    /** constructor with label, weight and the graph ID of the end vertex */
+    Edge(const std::string& end, int weight, int endId);
+
     /** return the vertex this edge connects to */
     std::string getEndVertex() const;
 
     /** return the weight/cost of travlleing via this edge */
     int getWeight() const;
 
+    /** return the graph ID of the end vertex, -1 if not known */
+    int getEndId() const;
+
  private:
     /** end vertex, cannot be changed */
     std::string endVertex {""};
 
     /** edge weight, cannot be changed */
     int edgeWeight {0};
+
+    /** graph ID of end vertex, lets traversals skip the label lookup */
+    int endVertexId {-1};
 };  //  end Edge
 
 
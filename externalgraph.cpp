@@ -0,0 +1,408 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+
+#include "externalgraph.h"
+#include "graph.h"
+#include "labelhashmap.h"
+#include "shortestpath.h"
+
+/**
+ * A graph whose edges stay on disk, streamed a pass at a time
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+/** first bytes of every edge file */
+const char kMagic[8] = {'G', 'R', 'A', 'P', 'H', 'E', 'D', 'S'};
+
+/** call f(edge) for every edge line of a text graph file, as
+    Graph::readFile reads them; returns false if it cannot be opened */
+template <typename F>
+bool forEachTextEdge(const std::string& textPath, F&& f) {
+    std::ifstream inputFile(textPath);
+    if (!inputFile.is_open()) { return false; }
+    int numLines = 0;
+    std::string line;
+    inputFile >> numLines;
+    for (int i = 0; i < numLines; i++) {
+        EdgeRecord edge;
+        inputFile >> edge.start;
+        inputFile >> edge.end;
+        inputFile >> edge.edgeWeight;
+        f(edge);
+        getline(inputFile, line);
+    }
+    return true;
+}
+
+/** read the raw bytes of value */
+template <typename T>
+bool readValue(std::ifstream& in, T& value) {
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/** write the raw bytes of value */
+template <typename T>
+void writeValue(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+/** turn a text graph file into an edge file without loading its edges */
+bool ExternalGraph::convertTextFile(const std::string& textPath,
+                                    const std::string& path,
+                                    long long memoryEdges) {
+    // first pass: labels and the number of edges out of each
+    LabelHashMap<long long> index;
+    bool negative = false;
+    bool read = forEachTextEdge(textPath, [&](const EdgeRecord& edge) {
+        if (edge.start == edge.end) { return; }
+        (*index.insert(edge.start, 0).first)++;
+        index.insert(edge.end, 0);
+        negative |= edge.edgeWeight < 0;
+    });
+    if (!read) { return false; }
+    std::vector<std::string> sorted;
+    sorted.reserve(index.size());
+    for (const auto& entry : index) { sorted.push_back(entry.first); }
+    std::sort(sorted.begin(), sorted.end());
+    int n = static_cast<int>(sorted.size());
+    // from here on index holds IDs
+    std::vector<long long> listOffsets {0};
+    for (int i = 0; i < n; i++) {
+        long long* entry = index.find(sorted[i]);
+        listOffsets.push_back(listOffsets.back() + *entry);
+        *entry = i;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) { return false; }
+    writeHeader(out, sorted, listOffsets, negative);
+    // then one pass for each range of start vertices
+    std::vector<DiskEdge> batch;
+    for (int first = 0; first < n;) {
+        int last = first + 1;
+        while (last < n &&
+               listOffsets[last + 1] - listOffsets[first] <= memoryEdges) {
+            last++;
+        }
+        batch.clear();
+        read = forEachTextEdge(textPath, [&](const EdgeRecord& edge) {
+            if (edge.start == edge.end) { return; }
+            int start = static_cast<int>(*index.find(edge.start));
+            if (start < first || start >= last) { return; }
+            batch.push_back({start, static_cast<int>(*index.find(edge.end)),
+                             edge.edgeWeight});
+        });
+        if (!read) { return false; }
+        sortEdges(batch);
+        writeEdges(out, batch);
+        first = last;
+    }
+    return static_cast<bool>(out);
+}
+
+/** open the edge file at path, reading batchEdges edges at a time */
+ExternalGraph::ExternalGraph(const std::string& path, size_t batchEdges)
+    : batchEdges(std::max<size_t>(batchEdges, 1)) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    long long numVertices = 0;
+    long long negative = 0;
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !readValue(in, numVertices) || !readValue(in, numEdges) ||
+        !readValue(in, negative) ||
+        numVertices < 0 || numVertices > INT_MAX || numEdges < 0) {
+        numEdges = 0;
+        return;
+    }
+    negativeWeights = negative != 0;
+    labels.resize(numVertices);
+    bool ok = true;
+    for (auto& label : labels) {
+        uint32_t length = 0;
+        if (!readValue(in, length)) {
+            ok = false;
+            break;
+        }
+        label.resize(length);
+        if (!in.read(label.data(), length)) {
+            ok = false;
+            break;
+        }
+    }
+    offsets.resize(numVertices + 1);
+    for (long long& offset : offsets) {
+        if (!ok || !readValue(in, offset)) {
+            ok = false;
+            break;
+        }
+    }
+    ok = ok && offsets.front() == 0 && offsets.back() == numEdges &&
+         std::is_sorted(offsets.begin(), offsets.end());
+    if (!ok) {
+        labels.clear();
+        offsets.clear();
+        numEdges = 0;
+        return;
+    }
+    edgeStart = static_cast<long long>(in.tellg());
+    fd = ::open(path.c_str(), O_RDONLY);
+}
+
+/** close the edge file */
+ExternalGraph::~ExternalGraph() {
+    if (fd != -1) { ::close(fd); }
+}
+
+/** return true if the edge file was opened and read */
+bool ExternalGraph::isOpen() const {
+    return fd != -1;
+}
+
+/** return number of vertices */
+int ExternalGraph::getNumVertices() const {
+    return static_cast<int>(labels.size());
+}
+
+/** return number of edges */
+long long ExternalGraph::getNumEdges() const {
+    return numEdges;
+}
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int ExternalGraph::findId(const std::string& vertexLabel) const {
+    auto it = std::lower_bound(labels.begin(), labels.end(), vertexLabel);
+    if (it == labels.end() || *it != vertexLabel) { return -1; }
+    return static_cast<int>(it - labels.begin());
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& ExternalGraph::getLabel(int id) const {
+    return labels[id];
+}
+
+/** return the number of passes over the edge file so far */
+long long ExternalGraph::getNumPasses() const {
+    return numPasses.load(std::memory_order_relaxed);
+}
+
+/** the edge file as a graph view (see traversal.h) for shortestpath,
+    reading a vertex's list each time it is walked
+    walks must not nest, they share one list; failed is set if a list
+    could not be read */
+class ExternalGraph::DiskView {
+ public:
+    DiskView(const ExternalGraph& graph, bool& failed)
+        : graph(graph), failed(failed) {}
+
+    int getNumVertices() const { return graph.getNumVertices(); }
+
+    const std::string& getLabel(int id) const { return graph.getLabel(id); }
+
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const {
+        if (!graph.readList(id, list)) {
+            failed = true;
+            return true;
+        }
+        for (const DiskEdge& edge : list) {
+            if (!f(edge.end, edge.weight)) { return false; }
+        }
+        return true;
+    }
+
+ private:
+    const ExternalGraph& graph;
+    bool& failed;
+    mutable std::vector<DiskEdge> list;
+};  // end DiskView
+
+/** lowest cost from startId to every vertex */
+bool ExternalGraph::costToAllVertices(int startId,
+                                      std::vector<long long>& cost,
+                                      std::vector<int>& previous) const {
+    int n = getNumVertices();
+    if (startId < 0 || startId >= n) {
+        cost.assign(n, shortestpath::kUnreachable);
+        previous.assign(n, -1);
+        return true;
+    }
+    if (negativeWeights) {
+        return bellmanFordPasses(startId, cost, previous);
+    }
+    bool failed = false;
+    shortestpath::dijkstra(DiskView(*this, failed), startId, cost, previous);
+    return !failed;
+}
+
+/** Bellman-Ford passes for costToAllVertices with negative weights */
+bool ExternalGraph::bellmanFordPasses(int startId,
+                                      std::vector<long long>& cost,
+                                      std::vector<int>& previous) const {
+    int n = getNumVertices();
+    cost.assign(n, shortestpath::kUnreachable);
+    previous.assign(n, -1);
+    cost[startId] = 0;
+    // cost of the cheapest cycle back to the start, kept apart so the
+    // start's own cost stays 0
+    long long startCost = shortestpath::kUnreachable;
+    // an edge is only relaxed if its start vertex got cheaper since the
+    // edge was last looked at
+    std::vector<char> changedBefore(n, 0);
+    std::vector<char> changedNow(n, 0);
+    changedBefore[startId] = 1;
+    for (int pass = 1;; pass++) {
+        bool changed = false;
+        bool read = forEachEdge([&](const DiskEdge& edge) {
+            if (!changedBefore[edge.start] && !changedNow[edge.start]) {
+                return;
+            }
+            long long viaStart = cost[edge.start] + edge.weight;
+            long long& best = edge.end == startId ? startCost
+                                                  : cost[edge.end];
+            if (viaStart < best) {
+                best = viaStart;
+                previous[edge.end] = edge.start;
+                if (edge.end != startId) {
+                    changedNow[edge.end] = 1;
+                    changed = true;
+                }
+            }
+        });
+        if (!read) { return false; }
+        if (!changed) { return true; }
+        // costs still falling after n passes means a negative cycle
+        if (pass >= n) { return false; }
+        changedBefore.swap(changedNow);
+        std::fill(changedNow.begin(), changedNow.end(), 0);
+    }
+}
+
+/** find the lowest cost from startLabel to all vertices that can be
+    reached, output as in Graph::djikstraCostToAllVertices */
+bool ExternalGraph::djikstraCostToAllVertices(
+    const std::string& startLabel,
+    std::map<std::string, int>& weight,
+    std::map<std::string, std::string>& previous) const {
+    weight.clear();
+    previous.clear();
+    int startId = findId(startLabel);
+    if (startId == -1) { return true; }
+    std::vector<long long> cost;
+    std::vector<int> previousId;
+    if (!costToAllVertices(startId, cost, previousId)) { return false; }
+    bool failed = false;
+    long long startCost = shortestpath::cycleCost(DiskView(*this, failed),
+                                                  startId, cost, previousId);
+    if (failed) { return false; }
+    shortestpath::toLabels(*this, startId, cost, previousId, weight,
+                           previous, startCost);
+    return true;
+}
+
+/** write the file header, the labels, sorted, and listOffsets */
+void ExternalGraph::writeHeader(std::ofstream& out,
+                                const std::vector<std::string>& labels,
+                                const std::vector<long long>& listOffsets,
+                                bool negative) {
+    out.write(kMagic, sizeof(kMagic));
+    writeValue(out, static_cast<long long>(labels.size()));
+    writeValue(out, listOffsets.back());
+    writeValue(out, static_cast<long long>(negative));
+    for (const auto& label : labels) {
+        writeValue(out, static_cast<uint32_t>(label.size()));
+        out.write(label.data(), static_cast<std::streamsize>(label.size()));
+    }
+    out.write(reinterpret_cast<const char*>(listOffsets.data()),
+              static_cast<std::streamsize>(listOffsets.size() *
+                                           sizeof(long long)));
+}
+
+/** sort edges by start, then end, keeping repeated edges in order */
+void ExternalGraph::sortEdges(std::vector<DiskEdge>& edges) {
+    std::stable_sort(edges.begin(), edges.end(),
+                     [](const DiskEdge& a, const DiskEdge& b) {
+        if (a.start != b.start) { return a.start < b.start; }
+        return a.end < b.end;
+    });
+}
+
+/** write batch and clear it */
+void ExternalGraph::writeEdges(std::ofstream& out,
+                               std::vector<DiskEdge>& batch) {
+    out.write(reinterpret_cast<const char*>(batch.data()),
+              static_cast<std::streamsize>(batch.size() * sizeof(DiskEdge)));
+    batch.clear();
+}
+
+/** read the next batch of at most batch.size() edges from position */
+long long ExternalGraph::readBatch(long long position,
+                                   std::vector<DiskEdge>& batch) const {
+    long long count = std::min(static_cast<long long>(batch.size()),
+                               numEdges - position);
+    size_t wanted = static_cast<size_t>(count) * sizeof(DiskEdge);
+    char* data = reinterpret_cast<char*>(batch.data());
+    off_t offset = edgeStart + position * sizeof(DiskEdge);
+    for (size_t done = 0; done < wanted;) {
+        ssize_t got = ::pread(fd, data + done, wanted - done, offset + done);
+        if (got <= 0) { return -1; }
+        done += got;
+    }
+    return count;
+}
+
+/** read the list of vertex id into list */
+bool ExternalGraph::readList(int id, std::vector<DiskEdge>& list) const {
+    if (fd == -1) { return false; }
+    list.resize(static_cast<size_t>(offsets[id + 1] - offsets[id]));
+    return list.empty() ||
+           readBatch(offsets[id], list) == static_cast<long long>(list.size());
+}
+
+/** next BFS level after frontier, in visiting order */
+std::vector<int> ExternalGraph::bfsExpand(
+    const std::vector<int>& frontier, std::vector<char>& visited,
+    std::vector<int>& place, std::vector<int>& parentPlace) const {
+    for (int i = 0; i < static_cast<int>(frontier.size()); i++) {
+        place[frontier[i]] = i;
+    }
+    // a new vertex belongs to its earliest parent in the frontier
+    std::vector<int> level;
+    bool read = forEachEdge([&](const DiskEdge& edge) {
+        int parent = place[edge.start];
+        if (parent == -1 || visited[edge.end]) { return; }
+        int& best = parentPlace[edge.end];
+        if (best == -1) { level.push_back(edge.end); }
+        if (best == -1 || parent < best) { best = parent; }
+    });
+    for (int v : frontier) { place[v] = -1; }
+    if (!read) {
+        // a file that cannot be read ends the traversal
+        for (int v : level) { parentPlace[v] = -1; }
+        return {};
+    }
+    // each parent's neighbors come in label order, which is ID order
+    std::sort(level.begin(), level.end(), [&parentPlace](int a, int b) {
+        if (parentPlace[a] != parentPlace[b]) {
+            return parentPlace[a] < parentPlace[b];
+        }
+        return a < b;
+    });
+    for (int v : level) {
+        visited[v] = 1;
+        parentPlace[v] = -1;
+    }
+    return level;
+}
@@ -0,0 +1,270 @@
+/**
+ * A graph whose edges stay on disk, for graphs too big to load
+ * Per-vertex state (labels, where each list starts, visited marks,
+ * costs, predecessors) is kept in memory; the edges stay in the edge
+ * file, sorted by start vertex so one vertex's list can be read alone
+ *
+ * Vertices are numbered in label order and neighbors are taken in label
+ * order, as in a Graph built with NeighborOrder::Alphabetical
+ * Breadth-first traversal reads the file front to back in fixed size
+ * batches, one whole pass per level, in the edge-centric style of
+ * X-Stream: each pass scatters updates from the edges whose start vertex
+ * is in the frontier and gathers them into the vertex state. It visits
+ * vertices in the same order as Graph::breadthFirstTraversal
+ * Shortest paths on a file without negative weights run Dijkstra with
+ * the heap in memory, reading each vertex's list when it is settled
+ * (semi-external Dijkstra), so results match Graph, ties included. With
+ * negative weights they take passes of Bellman-Ford relaxation until no
+ * cost changes, and each vertex keeps the last vertex that lowered its
+ * cost, as shortestpath::bellmanFord does
+ *
+ * Edge file layout, native byte order:
+ *     "GRAPHEDS", int64 number of vertices, int64 number of edges,
+ *     int64 1 if any weight is below zero, else 0,
+ *     each label as uint32 length and its bytes, in label order,
+ *     int64 place of each vertex's first edge, then the number of edges,
+ *     each edge as int32 start ID, int32 end ID, int32 weight, sorted by
+ *     start ID, then end ID
+ */
+
+#ifndef EXTERNALGRAPH_H
+#define EXTERNALGRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "traversal.h"
+
+class ExternalGraph {
+ public:
+    /** one edge as stored in the edge file */
+    struct DiskEdge {
+        int32_t start;
+        int32_t end;
+        int32_t weight;
+    };
+
+    /** write graph as an edge file at path, returns false on error */
+    template <typename GraphView>
+    static bool writeFile(const GraphView& graph, const std::string& path);
+
+    /** turn a text file in the format of Graph::readFile into an edge
+        file without loading all its edges: one pass collects the labels
+        and the number of edges out of each vertex, then each further
+        pass sorts and writes the lists of a range of start vertices
+        holding at most memoryEdges edges, or one list if it alone is
+        longer. Self-loops are dropped; unlike Graph, an edge given twice
+        is kept twice and the cheaper one wins
+        returns false on error */
+    static bool convertTextFile(const std::string& textPath,
+                                const std::string& path,
+                                long long memoryEdges = 1 << 22);
+
+    /** open the edge file at path, reading batchEdges edges at a time */
+    explicit ExternalGraph(const std::string& path,
+                           size_t batchEdges = 1 << 16);
+
+    /** close the edge file */
+    ~ExternalGraph();
+
+    ExternalGraph(const ExternalGraph&) = delete;
+    ExternalGraph& operator=(const ExternalGraph&) = delete;
+
+    /** return true if the edge file was opened and read */
+    bool isOpen() const;
+
+    /** return number of vertices */
+    int getNumVertices() const;
+
+    /** return number of edges */
+    long long getNumEdges() const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist
+        IDs run from 0 to getNumVertices() - 1 in label order */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID */
+    const std::string& getLabel(int id) const;
+
+    /** return the number of passes over the edge file so far */
+    long long getNumPasses() const;
+
+    /** breadth-first traversal starting from startLabel, visits vertices
+        in the same order as Graph::breadthFirstTraversal
+        visit can be any callable, see traversal.h */
+    template <typename Visitor>
+    void breadthFirstTraversal(const std::string& startLabel,
+                               Visitor&& visit) const;
+
+    /** lowest cost from startId to every vertex, 64-bit, as in
+        shortestpath::dijkstra; weights may be negative, and previous[v]
+        is then the last vertex that lowered v's cost
+        returns false if a negative cycle can be reached from startId, or
+        the edge file could not be read */
+    bool costToAllVertices(int startId, std::vector<long long>& cost,
+                           std::vector<int>& previous) const;
+
+    /** find the lowest cost from startLabel to all vertices that can be
+        reached, output as in Graph::djikstraCostToAllVertices
+        returns false if costToAllVertices does */
+    bool djikstraCostToAllVertices(
+        const std::string& startLabel,
+        std::map<std::string, int>& weight,
+        std::map<std::string, std::string>& previous) const;
+
+ private:
+    /** the edge file as a graph view for shortestpath, see the .cpp */
+    class DiskView;
+
+    /** call f(edge) for every edge in file order, one batch in memory
+        returns false if the file could not be read */
+    template <typename F>
+    bool forEachEdge(F&& f) const;
+
+    /** Bellman-Ford passes for costToAllVertices with negative weights */
+    bool bellmanFordPasses(int startId, std::vector<long long>& cost,
+                           std::vector<int>& previous) const;
+
+    /** write the file header, the labels, sorted, and listOffsets */
+    static void writeHeader(std::ofstream& out,
+                            const std::vector<std::string>& labels,
+                            const std::vector<long long>& listOffsets,
+                            bool negative);
+
+    /** sort edges by start, then end, keeping repeated edges in order */
+    static void sortEdges(std::vector<DiskEdge>& edges);
+
+    /** write batch and clear it */
+    static void writeEdges(std::ofstream& out, std::vector<DiskEdge>& batch);
+
+    /** read the list of vertex id into list, returns false on error */
+    bool readList(int id, std::vector<DiskEdge>& list) const;
+
+    /** read the next batch of at most batch.size() edges from position,
+        returns the number read, -1 on error */
+    long long readBatch(long long position,
+                        std::vector<DiskEdge>& batch) const;
+
+    /** next BFS level after frontier, in visiting order, in one pass
+        place and parentPlace are scratch space of one -1 per vertex,
+        left as they were given */
+    std::vector<int> bfsExpand(const std::vector<int>& frontier,
+                               std::vector<char>& visited,
+                               std::vector<int>& place,
+                               std::vector<int>& parentPlace) const;
+
+    /** vertex labels by ID, sorted */
+    std::vector<std::string> labels;
+
+    /** place in the file of each vertex's first edge, by ID, and
+        numEdges at the end */
+    std::vector<long long> offsets;
+
+    /** true if any weight is below zero */
+    bool negativeWeights {false};
+
+    /** open edge file, -1 if none */
+    int fd {-1};
+
+    /** byte offset of the first edge in the file */
+    long long edgeStart {0};
+
+    /** number of edges */
+    long long numEdges {0};
+
+    /** edges read per batch */
+    size_t batchEdges;
+
+    /** passes over the edge file so far */
+    mutable std::atomic<long long> numPasses {0};
+};  // end ExternalGraph
+
+/** write graph as an edge file at path */
+template <typename GraphView>
+bool ExternalGraph::writeFile(const GraphView& graph,
+                              const std::string& path) {
+    int n = graph.getNumVertices();
+    std::vector<int> order(n);
+    for (int v = 0; v < n; v++) { order[v] = v; }
+    std::sort(order.begin(), order.end(), [&graph](int a, int b) {
+        return graph.getLabel(a) < graph.getLabel(b);
+    });
+    std::vector<std::string> sorted;
+    std::vector<int32_t> newId(n);
+    sorted.reserve(n);
+    for (int i = 0; i < n; i++) {
+        newId[order[i]] = i;
+        sorted.push_back(graph.getLabel(order[i]));
+    }
+    // lists are written in label order of their start vertex
+    std::vector<long long> listOffsets {0};
+    bool negative = false;
+    for (int i = 0; i < n; i++) {
+        long long degree = 0;
+        graph.forEachNeighbor(order[i], [&](int, int edgeWeight) {
+            degree++;
+            negative |= edgeWeight < 0;
+            return true;
+        });
+        listOffsets.push_back(listOffsets.back() + degree);
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) { return false; }
+    writeHeader(out, sorted, listOffsets, negative);
+    std::vector<DiskEdge> list;
+    for (int i = 0; i < n; i++) {
+        graph.forEachNeighbor(order[i], [&](int endId, int edgeWeight) {
+            list.push_back({i, newId[endId], edgeWeight});
+            return true;
+        });
+        sortEdges(list);
+        writeEdges(out, list);
+    }
+    return static_cast<bool>(out);
+}
+
+/** call f(edge) for every edge in file order */
+template <typename F>
+bool ExternalGraph::forEachEdge(F&& f) const {
+    if (fd == -1) { return false; }
+    numPasses++;
+    std::vector<DiskEdge> batch(batchEdges);
+    for (long long done = 0; done < numEdges;) {
+        long long count = readBatch(done, batch);
+        if (count <= 0) { return false; }
+        for (long long i = 0; i < count; i++) { f(batch[i]); }
+        done += count;
+    }
+    return true;
+}
+
+/** breadth-first traversal starting from startLabel */
+template <typename Visitor>
+void ExternalGraph::breadthFirstTraversal(const std::string& startLabel,
+                                          Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId == -1) { return; }
+    std::vector<char> visited(getNumVertices(), 0);
+    std::vector<int> place(getNumVertices(), -1);
+    std::vector<int> parentPlace(getNumVertices(), -1);
+    visited[startId] = 1;
+    std::vector<int> level {startId};
+    while (!level.empty()) {
+        std::vector<int> frontier;
+        for (int v : level) {
+            VisitAction action = traversal::detail::callVisitor(
+                visit, VertexHandle<ExternalGraph>(*this, v));
+            if (action == VisitAction::Stop) { return; }
+            if (action == VisitAction::Continue) { frontier.push_back(v); }
+        }
+        if (frontier.empty()) { return; }
+        level = bfsExpand(frontier, visited, place, parentPlace);
+    }
+}
+
+#endif  // EXTERNALGRAPH_H
@@ -1,12 +1,15 @@
-#include <queue>
 #include <climits>
-#include <set>
 #include <iostream>
 #include <fstream>
 #include <map>
 #include <functional>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
 
 #include "graph.h"
+#include "shortestpath.h"
 
 /**
  * A graph is made up of vertices and edges
@@ -19,19 +22,21 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
-/** constructor, empty graph */
-Graph::Graph() {
+/** constructor, empty graph
+    order picks the storage for the vertex index and adjacency lists */
+Graph::Graph(NeighborOrder order) {
     numberOfVertices = 0;
     numberOfEdges = 0;
+    neighborOrder = order;
 }
 
 /** destructor, delete all vertices and edges
     only vertices stored in map
     no pointers to edges created by graph */
 Graph::~Graph() {
-    for(auto i = vertices.begin(); i != vertices.end(); ++i) {
-        delete i->second;
-        i->second = nullptr;
+    for (auto*& vertexPtr : vertexById) {
+        delete vertexPtr;
+        vertexPtr = nullptr;
     }
 }
 
@@ -45,6 +50,31 @@ int Graph::getNumEdges() const {
     return numberOfEdges; 
 }
 
+/** return how vertices and neighbors are stored */
+NeighborOrder Graph::getNeighborOrder() const {
+    return neighborOrder;
+}
+
+/** run addEdges, readFile, traversals and djikstraCostToAllVertices
+    on pool; nullptr runs everything on the calling thread */
+void Graph::setThreadPool(std::shared_ptr<ThreadPool> pool) {
+    threadPool = std::move(pool);
+}
+
+/** return the pool set by setThreadPool, nullptr if none */
+std::shared_ptr<ThreadPool> Graph::getThreadPool() const {
+    return threadPool;
+}
+
+/** return a CsrGraph copy of the graph, built on the thread pool */
+std::shared_ptr<const CsrGraph> Graph::getCsrView() const {
+    std::lock_guard<std::mutex> lock(csrViewLock);
+    if (csrView == nullptr) {
+        csrView = std::make_shared<const CsrGraph>(*this, threadPool.get());
+    }
+    return csrView;
+}
+
 /** add a new edge between start and end vertex
     if the vertices do not exist, create them
     calls Vertex::connect
@@ -55,22 +85,108 @@ bool Graph::add(std::string start, std::string end, int edgeWeight) {
         // Create the vertices if they don't exist
         auto* startPtr = findOrCreateVertex(start);
         auto* endPtr = findOrCreateVertex(end);
-        bool canConnect = startPtr->connect(end, edgeWeight);
-        if (canConnect) { numberOfEdges++; }
-        // Add the vertices to vertices map if they don't exist
-        if (canConnect && vertices.count(start) == 0) {
-            vertices[start] = startPtr;
-            numberOfVertices++;
-        }
-        if (canConnect && vertices.count(end) == 0) {
-            vertices[end] = endPtr;
-            numberOfVertices++;
+        bool canConnect = startPtr->connect(*endPtr, edgeWeight);
+        if (canConnect) {
+            numberOfEdges++;
+            csrView.reset();
         }
         return canConnect;
     }
     return false;
 }
 
+/** add a batch of edges, same result as calling add on each in order
+    self-loops and edges that already exist (in the graph or earlier
+    in the batch) are skipped
+    the batch is sorted by start vertex and merged into each adjacency
+    list in one pass, spread over the thread pool if there is one
+    returns the number of edges added */
+int Graph::addEdges(const std::vector<EdgeRecord>& edges) {
+    struct PendingEdge {
+        int start;
+        int end;
+        int edgeWeight;
+        size_t order;
+    };
+    // Create vertices in the same order add would
+    std::vector<PendingEdge> pending;
+    pending.reserve(edges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        const EdgeRecord& edge = edges[i];
+        if (edge.start == edge.end) { continue; }
+        int startId = findOrCreateVertex(edge.start)->getId();
+        int endId = findOrCreateVertex(edge.end)->getId();
+        pending.push_back({startId, endId, edge.edgeWeight, i});
+    }
+    // Group by start vertex, keep the first of any repeated edge
+    std::sort(pending.begin(), pending.end(),
+              [](const PendingEdge& a, const PendingEdge& b) {
+        if (a.start != b.start) { return a.start < b.start; }
+        if (a.end != b.end) { return a.end < b.end; }
+        return a.order < b.order;
+    });
+    pending.erase(std::unique(pending.begin(), pending.end(),
+                              [](const PendingEdge& a, const PendingEdge& b) {
+        return a.start == b.start && a.end == b.end;
+    }), pending.end());
+    // Within a group, put edges in the order the adjacency list keeps them
+    std::vector<size_t> groups;
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (i == 0 || pending[i].start != pending[i - 1].start) {
+            groups.push_back(i);
+        }
+    }
+    groups.push_back(pending.size());
+    for (size_t g = 0; g + 1 < groups.size(); g++) {
+        auto first = pending.begin() + groups[g];
+        auto last = pending.begin() + groups[g + 1];
+        if (neighborOrder == NeighborOrder::Insertion) {
+            std::sort(first, last,
+                      [](const PendingEdge& a, const PendingEdge& b) {
+                return a.order < b.order;
+            });
+        } else {
+            std::sort(first, last,
+                      [this](const PendingEdge& a, const PendingEdge& b) {
+                return getLabel(a.end) < getLabel(b.end);
+            });
+        }
+    }
+    std::vector<std::pair<const Vertex*, int>> targets;
+    targets.reserve(pending.size());
+    for (const auto& edge : pending) {
+        targets.emplace_back(vertexById[edge.end], edge.edgeWeight);
+    }
+    // Each group touches only its own start vertex, so groups can be
+    // merged in parallel, split so each task gets about the same edges;
+    // groupOffsets is where each group starts, the prefix array
+    // parallelForWeighted takes
+    std::vector<long long> groupOffsets(groups.begin(), groups.end());
+    std::atomic<int> totalAdded {0};
+    auto mergeGroup = [&](size_t g) {
+        auto* startPtr = vertexById[pending[groups[g]].start];
+        totalAdded += startPtr->connectAll(
+            targets.data() + groups[g],
+            static_cast<int>(groups[g + 1] - groups[g]));
+    };
+    if (threadPool == nullptr) {
+        for (size_t g = 0; g + 1 < groups.size(); g++) {
+            mergeGroup(g);
+        }
+    } else {
+        // a vertex's merge cannot be split, the weights only balance tasks
+        const long long grain = 4096;
+        threadPool->parallelForWeighted(groupOffsets, grain,
+                                        [&](long long g, long long from,
+                                            long long) {
+            if (from == 0) { mergeGroup(g); }
+        });
+    }
+    numberOfEdges += totalAdded;
+    if (totalAdded > 0) { csrView.reset(); }
+    return totalAdded;
+}
+
 /** return weight of the edge between start and end
     returns INT_MAX if not connected or vertices don't exist */
 int Graph::getEdgeWeight(std::string start, std::string end) const { 
@@ -95,54 +211,68 @@ void Graph::readFile(std::string filename) {
     std::ifstream inputFile;
     inputFile.open(filename);
     if (inputFile.is_open()) {
+        // add edges in batches so large files don't pay per-edge overhead
+        // lines are read in order as always, addEdges spreads the
+        // insertion of each batch over the thread pool
+        const int batchSize = 1 << 16;
+        std::vector<EdgeRecord> batch;
         std::string line;
         int numLines;
         inputFile >> numLines;
         for (int i = 0; i < numLines; i++) {
-            std::string start, end;
-            int weight;
-            inputFile >> start;
-            inputFile >> end;
-            inputFile >> weight;
-            add(start, end, weight);
+            EdgeRecord edge;
+            inputFile >> edge.start;
+            inputFile >> edge.end;
+            inputFile >> edge.edgeWeight;
+            batch.push_back(std::move(edge));
             getline(inputFile, line);
+            if (static_cast<int>(batch.size()) == batchSize) {
+                addEdges(batch);
+                batch.clear();
+            }
         }
+        addEdges(batch);
     }
 }
 
 /** depth-first traversal starting from startLabel
     call the function visit on each vertex label */
 void Graph::depthFirstTraversal(std::string startLabel, 
-void visit(const std::string&)) {
-    unvisitVertices();
-    auto* startVertex = findVertex(startLabel);
-    depthFirstTraversalHelper(startVertex, visit);
+void visit(const std::string&)) const {
+    depthFirstTraversal<void (&)(const std::string&)>(startLabel, *visit);
 }
 
 /** breadth-first traversal starting from startLabel
     call the function visit on each vertex label */
 void Graph::breadthFirstTraversal(std::string startLabel,
-void visit(const std::string&)) {
-    unvisitVertices();
-    std::queue<std::string> q;
-    q.push(startLabel);
-    auto* startVertex = findVertex(startLabel);
-    visit(startVertex->getLabel());
-    startVertex->visit();
-    while (!q.empty()) {
-        std::string wLabel = q.front();
-        q.pop();
-        auto* w = findVertex(wLabel);
-        for (int i = 0; i <= w->getNumberOfNeighbors(); i++) {
-            std::string uLabel = w->getNextNeighbor();
-            auto* u = findVertex(uLabel);
-            if (!u->isVisited()) {
-                visit(u->getLabel());
-                u->visit();
-                q.push(uLabel);
-            } 
-        }
+void visit(const std::string&)) const {
+    breadthFirstTraversal<void (&)(const std::string&)>(startLabel, *visit);
+}
+
+/** djikstraCostToAllVertices into either kind of map
+    building the CsrGraph copy only pays off when the edges of big
+    vertices can be spread over a pool, so without one the adjacency
+    lists are walked where they are */
+template <typename Cost>
+void Graph::djikstraToMaps(const std::string& startLabel,
+                           std::map<std::string, Cost>& weight,
+                           std::map<std::string, std::string>& previous) const {
+    if (threadPool != nullptr) {
+        ShortestPathResult result;
+        djikstraCostToAllVertices(startLabel, result);
+        result.toMaps(weight, previous);
+        return;
     }
+    weight.clear();
+    previous.clear();
+    int startId = findId(startLabel);
+    if (startId == -1) { return; }
+    std::vector<long long> cost;
+    std::vector<int> previousId;
+    shortestpath::dijkstra(*this, startId, cost, previousId);
+    shortestpath::toLabels(
+        *this, startId, cost, previousId, weight, previous,
+        shortestpath::cycleCost(*this, startId, cost, previousId));
 }
 
 /** find the lowest cost from startLabel to all vertices that can be reached
@@ -151,6 +281,8 @@ void visit(const std::string&)) {
     weight["F"] = 10 indicates the cost to get to "F" is 10
     record the shortest path to each vertex using given map previous
     previous["F"] = "C" indicates get to "F" via "C"
+    the start vertex is only listed if a cycle leads back to it
+    maps are empty if the start vertex does not exist
 
     cpplint gives warning to use pointer instead of a non-const map
     which I am ignoring for readability */
@@ -158,76 +290,125 @@ void Graph::djikstraCostToAllVertices(
     std::string startLabel,
     std::map<std::string, int>& weight,
     std::map<std::string, std::string>& previous) {
-        weight.clear();
-        previous.clear();
-        std::priority_queue<std::pair<int, std::string>> pq;
-        std::set<std::string> vertexSet;
-
-        auto* start = findVertex(startLabel);
-        for (int i = 0; i < start->getNumberOfNeighbors(); i++) {
-            std::string uLabel = start->getNextNeighbor();
-            int weightU = start->getEdgeWeight(uLabel);
-            weight[uLabel] = weightU;
-            previous[uLabel] = startLabel;
-            pq.push(std::make_pair(-weightU, uLabel));
-        }
-        vertexSet.insert(startLabel);
-        while (!pq.empty()) {
-            std::string vLabel = pq.top().second;
-            pq.pop();
-            if (vertexSet.count(vLabel) == 0) {
-                vertexSet.insert(vLabel);
-                auto* v = findVertex(vLabel);
-                int weightV = weight.find(vLabel)->second;
-                for (int i = 0; i < v->getNumberOfNeighbors(); i++) {
-                    std::string uLabel = v->getNextNeighbor();
-                    int v2ucost = v->getEdgeWeight(uLabel);
-                    if (weight[uLabel] == 0) {
-                        weight[uLabel] = weight[vLabel] + v2ucost;
-                        previous[uLabel] = vLabel; 
-                        pq.push(std::make_pair(-(weightV + v2ucost), uLabel));
-                    }
-                    else {
-                        if (weight[uLabel] > (weight[vLabel] + v2ucost)) {
-                            weight[uLabel] = weight[vLabel] + v2ucost;
-                            previous[uLabel] = vLabel; 
-                            pq.push(std::make_pair(-(weightV + v2ucost), 
-                            uLabel));
-                        }
-                    }
-                }
+    djikstraToMaps(startLabel, weight, previous);
+}
+
+/** djikstraCostToAllVertices with 64-bit costs */
+void Graph::djikstraCostToAllVertices(
+    std::string startLabel,
+    std::map<std::string, long long>& weight,
+    std::map<std::string, std::string>& previous) {
+    djikstraToMaps(startLabel, weight, previous);
+}
+
+/** djikstraCostToAllVertices into flat arrays by vertex ID */
+void Graph::djikstraCostToAllVertices(const std::string& startLabel,
+                                      ShortestPathResult& result) const {
+    // relax over the flat copy, each edge's target and weight sit
+    // next to each other instead of in per-vertex maps
+    result.view = getCsrView();
+    result.startId = result.view->findId(startLabel);
+    if (result.startId == -1) {
+        result.cost.assign(result.view->getNumVertices(),
+                           shortestpath::kUnreachable);
+        result.previous.assign(result.view->getNumVertices(), -1);
+        return;
+    }
+    shortestpath::dijkstraCsr(*result.view, result.startId, result.cost,
+                              result.previous, result.workspace,
+                              threadPool.get());
+}
+
+/** lowest cost from startLabel to all vertices, weights may be negative
+    returns false if a negative cycle can be reached from startLabel */
+bool Graph::bellmanFordCostToAllVertices(
+    const std::string& startLabel,
+    std::map<std::string, long long>& weight,
+    std::map<std::string, std::string>& previous) const {
+    weight.clear();
+    previous.clear();
+    int startId = findId(startLabel);
+    if (startId == -1) { return true; }
+    auto csr = getCsrView();
+    std::vector<long long> cost;
+    std::vector<int> previousId;
+    if (!shortestpath::bellmanFord(*csr, startId, cost, previousId)) {
+        return false;
+    }
+    // the start is listed with its cheapest cycle, from the final costs
+    // of the vertices with an edge into it
+    long long startCost = shortestpath::kUnreachable;
+    for (int v = 0; v < csr->getNumVertices(); v++) {
+        if (cost[v] == shortestpath::kUnreachable) { continue; }
+        csr->forEachNeighbor(v, [&](int u, int edgeWeight) {
+            if (u == startId && cost[v] + edgeWeight < startCost) {
+                startCost = cost[v] + edgeWeight;
+                previousId[startId] = v;
             }
-        }
+            return true;
+        });
     }
+    shortestpath::toLabels(*csr, startId, cost, previousId, weight,
+                           previous, startCost);
+    return true;
+}
 
+/** lowest cost between every pair of vertices, weights may be negative
+    returns false if the graph has a negative cycle */
+bool Graph::johnsonCostAllPairs(
+    std::map<std::string, std::map<std::string, long long>>& weight) const {
+    weight.clear();
+    auto csr = getCsrView();
+    std::vector<std::vector<long long>> cost;
+    std::vector<std::vector<int>> previousId;
+    if (!shortestpath::johnson(*csr, cost, previousId, threadPool.get())) {
+        return false;
+    }
+    std::map<std::string, std::string> unused;
+    for (int s = 0; s < numberOfVertices; s++) {
+        shortestpath::toLabels(*csr, s, cost[s], previousId[s],
+                               weight[getLabel(s)], unused);
+    }
+    return true;
+}
 
-/** helper for depthFirstTraversal */
-void Graph::depthFirstTraversalHelper(Vertex* startVertex,
-void visit(const std::string&)) {
-    visit(startVertex->getLabel());
-    startVertex->visit();
-    for (int i = 0; i < startVertex->getNumberOfNeighbors(); i++) {
-        std::string nLabel = startVertex->getNextNeighbor();
-        auto* n = findVertex(nLabel);
-        if (!n->isVisited()) {
-            depthFirstTraversalHelper(n, visit);
-        }
+/** minimum spanning forest, edges taken as undirected
+    returns the total weight */
+long long Graph::minimumSpanningForest(std::vector<EdgeRecord>& edges,
+                                       spanningtree::MergeRule rule) const {
+    auto csr = getCsrView();
+    spanningtree::SpanningForest forest =
+        threadPool == nullptr
+            ? spanningtree::kruskal(*csr, rule)
+            : spanningtree::boruvka(*csr, rule, threadPool.get());
+    edges.clear();
+    edges.reserve(forest.edges.size());
+    for (const auto& edge : forest.edges) {
+        const std::string& a = csr->getLabel(edge.start);
+        const std::string& b = csr->getLabel(edge.end);
+        edges.push_back({std::min(a, b), std::max(a, b), edge.weight});
     }
+    return forest.totalWeight;
 }
 
+
 /** helper for breadthFirstTraversal */
 // void Graph::breadthFirstTraversalHelper(Vertex*startVertex,
 //                                         void visit(const std::string&)) {}
 
 /** mark all verticies as unvisited */
 void Graph::unvisitVertices() {
-    for (auto i = vertices.begin(); i != vertices.end(); ++i) {
-        i->second->unvisit();
+    for (auto* vertexPtr : vertexById) {
+        vertexPtr->unvisit();
     }
 }
 
 /** find a vertex, if it does not exist return nullptr */
 Vertex* Graph::findVertex(const std::string& vertexLabel) const { 
+    if (neighborOrder == NeighborOrder::Insertion) {
+        auto* found = hashedVertices.find(vertexLabel);
+        return found == nullptr ? nullptr : *found;
+    }
     if (vertices.count(vertexLabel) != 0) {
         auto* vertexPtr = vertices.at(vertexLabel);
         return vertexPtr;
@@ -235,11 +416,41 @@ Vertex* Graph::findVertex(const std::string& vertexLabel) const {
     return nullptr; 
 }
 
-/** find a vertex, if it does not exist create it and return it */
+/** find a vertex, if it does not exist create it and return it
+    new vertices get the next free ID */
 Vertex* Graph::findOrCreateVertex(const std::string& vertexLabel) { 
+    if (neighborOrder == NeighborOrder::Insertion) {
+        // hash the label once for both the lookup and the insert
+        size_t hash = LabelHashMap<Vertex*>::hashLabel(vertexLabel);
+        auto* found = hashedVertices.find(vertexLabel, hash);
+        if (found != nullptr) { return *found; }
+        auto* vertexPtr = new Vertex(vertexLabel, numberOfVertices,
+                                     neighborOrder);
+        hashedVertices.insert(vertexLabel, hash, vertexPtr);
+        vertexById.push_back(vertexPtr);
+        numberOfVertices++;
+        csrView.reset();
+        return vertexPtr;
+    }
     auto* vertexPtr = findVertex(vertexLabel);
     if (vertexPtr == nullptr) {
-        vertexPtr = new Vertex(vertexLabel);
+        vertexPtr = new Vertex(vertexLabel, numberOfVertices);
+        vertices[vertexLabel] = vertexPtr;
+        vertexById.push_back(vertexPtr);
+        numberOfVertices++;
+        csrView.reset();
     }
     return vertexPtr; 
 }
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int Graph::findId(const std::string& vertexLabel) const {
+    auto* vertexPtr = findVertex(vertexLabel);
+    return vertexPtr == nullptr ? -1 : vertexPtr->getId();
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& Graph::getLabel(int id) const {
+    return vertexById[id]->getLabel();
+}
+
@@ -7,15 +7,34 @@
 #define GRAPH_H
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "vertex.h"
 #include "edge.h"
+#include "csrgraph.h"
+#include "shortestpathresult.h"
+#include "spanningtree.h"
+#include "threadpool.h"
+#include "traversal.h"
+
+/** one edge for Graph::addEdges */
+struct EdgeRecord {
+    std::string start;
+    std::string end;
+    int edgeWeight {0};
+};
 
 class Graph {
  public:
-    /** constructor, empty graph */
-    Graph();
+    /** constructor, empty graph
+        order picks the storage for the vertex index and adjacency lists
+        Alphabetical keeps std::map and visits neighbors in label order
+        Insertion uses LabelHashMap for O(1) add, lookup and getEdgeWeight
+        and visits neighbors in the order the edges were added */
+    explicit Graph(NeighborOrder order = NeighborOrder::Alphabetical);
 
     /** destructor, delete all vertices and edges
         only vertices stored in map
@@ -28,6 +47,21 @@ class Graph {
     /** return number of vertices */
     int getNumEdges() const;
 
+    /** return how vertices and neighbors are stored */
+    NeighborOrder getNeighborOrder() const;
+
+    /** run addEdges, readFile, traversals and djikstraCostToAllVertices
+        on pool; nullptr (the default) runs everything on the calling
+        thread. The pool can be shared with other graphs */
+    void setThreadPool(std::shared_ptr<ThreadPool> pool);
+
+    /** return the pool set by setThreadPool, nullptr if none */
+    std::shared_ptr<ThreadPool> getThreadPool() const;
+
+    /** return a CsrGraph copy of the graph, built on the thread pool
+        the copy is kept until the graph changes */
+    std::shared_ptr<const CsrGraph> getCsrView() const;
+
     /** add a new edge between start and end vertex
         if the vertices do not exist, create them
         calls Vertex::connect
@@ -35,6 +69,14 @@ class Graph {
         or have multiple edges to another vertex */
     bool add(std::string start, std::string end, int edgeWeight = 0);
 
+    /** add a batch of edges, same result as calling add on each in order
+        self-loops and edges that already exist (in the graph or earlier
+        in the batch) are skipped
+        the batch is sorted by start vertex and merged into each adjacency
+        list in one pass, spread over the thread pool if there is one
+        returns the number of edges added */
+    int addEdges(const std::vector<EdgeRecord>& edges);
+
     /** return weight of the edge between start and end
         returns INT_MAX if not connected or vertices don't exist */
     int getEdgeWeight(std::string start, std::string end) const;
@@ -48,12 +90,43 @@ class Graph {
     /** depth-first traversal starting from startLabel
         call the function visit on each vertex label */
     void depthFirstTraversal(std::string startLabel,
-                             void visit(const std::string&));
+                             void visit(const std::string&)) const;
 
     /** breadth-first traversal starting from startLabel
         call the function visit on each vertex label */
     void breadthFirstTraversal(std::string startLabel,
-                               void visit(const std::string&));
+                               void visit(const std::string&)) const;
+
+    /** depth-first traversal starting from startLabel
+        visit can be any callable, see traversal.h
+        it gets a VertexHandle and can prune or stop the search
+        does nothing if startLabel is not in the graph */
+    template <typename Visitor>
+    void depthFirstTraversal(const std::string& startLabel,
+                             Visitor&& visit) const;
+
+    /** breadth-first traversal starting from startLabel
+        visit can be any callable, see traversal.h
+        it gets a VertexHandle and can prune or stop the search
+        does nothing if startLabel is not in the graph
+        with a thread pool, each level is expanded in parallel and visit
+        is still called on this thread in the same order */
+    template <typename Visitor>
+    void breadthFirstTraversal(const std::string& startLabel,
+                               Visitor&& visit) const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist
+        IDs run from 0 to getNumVertices() - 1 in order of creation */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID */
+    const std::string& getLabel(int id) const;
+
+    /** call f(endId, edgeWeight) for each neighbor of vertex id
+        in neighbor order, stopping if f returns false
+        returns false if f stopped the walk */
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const;
 
     /** find the lowest cost from startLabel to all vertices that can be reached
         using Djikstra's shortest-path algorithm
@@ -61,6 +134,14 @@ class Graph {
         weight["F"] = 10 indicates the cost to get to "F" is 10
         record the shortest path to each vertex using given map previous
         previous["F"] = "C" indicates get to "F" via "C"
+        the start vertex is only listed if a cycle leads back to it, with
+        the cost of the cheapest one and the vertex closing it
+        maps are empty if the start vertex does not exist
+        edge weights must not be negative, see bellmanFordCostToAllVertices
+        without a thread pool, walks the adjacency lists directly; with
+        one, runs on the CsrGraph copy with the SIMD kernel in
+        relaxkernel.h and relaxes the edges of vertices with many
+        neighbors in parallel
 
         cpplint gives warning to use pointer instead of a non-const map
         which I am ignoring for readability */
@@ -69,6 +150,55 @@ class Graph {
         std::map<std::string, int>& weight,
         std::map<std::string, std::string>& previous);
 
+    /** djikstraCostToAllVertices with 64-bit costs, so paths costing more
+        than INT_MAX are reported correctly; the int maps above leave the
+        vertices at the end of such paths out */
+    void djikstraCostToAllVertices(
+        std::string startLabel,
+        std::map<std::string, long long>& weight,
+        std::map<std::string, std::string>& previous);
+
+    /** djikstraCostToAllVertices into flat arrays by vertex ID, with
+        labels and paths looked up only when asked for; the map versions
+        above are built on this one when there is a thread pool
+        always runs on the CsrGraph copy
+        reusing result for later searches reuses its arrays */
+    void djikstraCostToAllVertices(const std::string& startLabel,
+                                   ShortestPathResult& result) const;
+
+    /** find the lowest cost from startLabel to all vertices that can be
+        reached when edge weights may be negative, using queue-based
+        Bellman-Ford; output as in djikstraCostToAllVertices with 64-bit
+        costs, but among equally cheap paths a different previous vertex
+        may be picked
+        returns false if a negative cycle can be reached from startLabel,
+        weight and previous are then empty */
+    bool bellmanFordCostToAllVertices(
+        const std::string& startLabel,
+        std::map<std::string, long long>& weight,
+        std::map<std::string, std::string>& previous) const;
+
+    /** find the lowest cost between every pair of vertices when edge
+        weights may be negative, using Johnson's algorithm
+        weight["A"]["F"] = 10 indicates the cost from "A" to "F" is 10
+        a vertex itself and vertices it cannot reach are left out
+        sources are spread over the thread pool if there is one
+        returns false if the graph has a negative cycle, weight is then
+        empty */
+    bool johnsonCostAllPairs(
+        std::map<std::string, std::map<std::string, long long>>& weight)
+        const;
+
+    /** minimum spanning forest, edges taken as undirected; where both
+        directions exist rule picks which weight counts
+        edges is filled with the forest's edges, cheapest first, the
+        smaller label as start
+        Boruvka's algorithm on the thread pool if there is one, otherwise
+        Kruskal's; returns the total weight */
+    long long minimumSpanningForest(
+        std::vector<EdgeRecord>& edges,
+        spanningtree::MergeRule rule = spanningtree::MergeRule::Min) const;
+
  private:
     /** number of vertices in graph */
     int numberOfVertices;
@@ -76,12 +206,26 @@ class Graph {
     /** number of edges in graph */
     int numberOfEdges;
 
+    /** storage used for vertices and their adjacency lists */
+    NeighborOrder neighborOrder;
+
     /** mapping from vertex label to vertex pointer for quick access */
     std::map<std::string, Vertex*> vertices;
 
-    /** helper for depthFirstTraversal */
-    void depthFirstTraversalHelper(Vertex* startVertex,
-                                   void visit(const std::string&));
+    /** vertices as a hash map, used instead for NeighborOrder::Insertion */
+    LabelHashMap<Vertex*> hashedVertices;
+
+    /** vertices indexed by their ID */
+    std::vector<Vertex*> vertexById;
+
+    /** pool for the parallel paths, nullptr to run on the calling thread */
+    std::shared_ptr<ThreadPool> threadPool;
+
+    /** CsrGraph copy returned by getCsrView, reset when the graph changes */
+    mutable std::shared_ptr<const CsrGraph> csrView;
+
+    /** guards csrView, so concurrent readers build it only once */
+    mutable std::mutex csrViewLock;
 
     /** helper for breadthFirstTraversal */
     void breadthFirstTraversalHelper(Vertex*startVertex,
@@ -90,11 +234,66 @@ class Graph {
     /** mark all verticies as unvisited */
     void unvisitVertices();
 
+    /** djikstraCostToAllVertices into either kind of map */
+    template <typename Cost>
+    void djikstraToMaps(const std::string& startLabel,
+                        std::map<std::string, Cost>& weight,
+                        std::map<std::string, std::string>& previous) const;
+
     /** find a vertex, if it does not exist return nullptr */
     Vertex* findVertex(const std::string& vertexLabel) const;
 
-    /** find a vertex, if it does not exist create it and return it */
+    /** find a vertex, if it does not exist create it and return it
+        new vertices get the next free ID */
     Vertex* findOrCreateVertex(const std::string& vertexLabel);
 };  // end Graph
 
+/** depth-first traversal starting from startLabel
+    visit can be any callable, see traversal.h */
+template <typename Visitor>
+void Graph::depthFirstTraversal(const std::string& startLabel,
+                                Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId == -1) { return; }
+    if (threadPool == nullptr) {
+        traversal::depthFirst(*this, startId, visit);
+        return;
+    }
+    // depth-first order is inherently sequential, the pool builds the
+    // flat copy and the walk itself runs here over its arrays
+    traversal::depthFirst(*getCsrView(), startId,
+                          [this, &visit](const VertexHandle<CsrGraph>& v) {
+        return traversal::detail::callVisitor(
+            visit, VertexHandle<Graph>(*this, v.getId()));
+    });
+}
+
+/** breadth-first traversal starting from startLabel
+    visit can be any callable, see traversal.h */
+template <typename Visitor>
+void Graph::breadthFirstTraversal(const std::string& startLabel,
+                                  Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId == -1) { return; }
+    if (threadPool == nullptr) {
+        traversal::breadthFirst(*this, startId, visit);
+        return;
+    }
+    traversal::breadthFirstParallel(
+        *getCsrView(), startId,
+        [this, &visit](const VertexHandle<CsrGraph>& v) {
+            return traversal::detail::callVisitor(
+                visit, VertexHandle<Graph>(*this, v.getId()));
+        },
+        *threadPool);
+}
+
+/** call f(endId, edgeWeight) for each neighbor of vertex id */
+template <typename F>
+bool Graph::forEachNeighbor(int id, F&& f) const {
+    return vertexById[id]->forEachEdge([&f](const Edge& edge) {
+        return f(edge.getEndId(), edge.getWeight());
+    });
+}
+
 #endif  // GRAPH_H
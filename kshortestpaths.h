@@ -0,0 +1,314 @@
+/**
+ * The k cheapest loopless paths between two vertices of any graph view
+ * (see traversal.h), using Yen's algorithm
+ * Edge weights must not be negative
+ *
+ * Each spur search is an A* search guided by one shortest-path tree to
+ * the end vertex, built once on the reversed graph. Banning edges only
+ * makes paths longer, so the tree distances stay a valid lower bound,
+ * and when the tree path from the spur vertex avoids everything banned
+ * it is the answer and no search is needed
+ * The spur searches of one round are independent and can run on a
+ * ThreadPool, each worker with its own work arrays
+ */
+
+#ifndef KSHORTESTPATHS_H
+#define KSHORTESTPATHS_H
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "shortestpath.h"
+#include "threadpool.h"
+
+namespace kshortestpaths {
+
+/** a path and its total cost */
+struct Path {
+    std::vector<int> vertices;
+    long long cost {0};
+};
+
+/** a path given by vertex labels and its total cost */
+struct LabeledPath {
+    std::vector<std::string> vertices;
+    long long cost {0};
+};
+
+namespace detail {
+
+/** a path with the cost of reaching each of its vertices */
+struct CostedPath {
+    std::vector<int> vertices;
+    std::vector<long long> costs;
+
+    long long cost() const { return costs.back(); }
+
+    /** cheaper first, ties broken by vertex IDs so results are stable */
+    bool operator<(const CostedPath& other) const {
+        if (cost() != other.cost()) { return cost() < other.cost(); }
+        return vertices < other.vertices;
+    }
+};
+
+/** incoming edges of every vertex, for the tree to the end vertex */
+template <typename GraphView>
+struct ReverseGraph {
+    const GraphView* graph;
+    std::vector<long long> offsets;
+    std::vector<int> sources;
+    std::vector<int> weights;
+
+    int getNumVertices() const {
+        return static_cast<int>(offsets.size()) - 1;
+    }
+
+    const std::string& getLabel(int id) const { return graph->getLabel(id); }
+
+    template <typename F>
+    bool forEachNeighbor(int id, F&& f) const {
+        for (long long i = offsets[id]; i < offsets[id + 1]; i++) {
+            if (!f(sources[i], weights[i])) { return false; }
+        }
+        return true;
+    }
+};
+
+/** build the reversed graph */
+template <typename GraphView>
+ReverseGraph<GraphView> reverse(const GraphView& graph) {
+    int n = graph.getNumVertices();
+    ReverseGraph<GraphView> rev;
+    rev.graph = &graph;
+    rev.offsets.assign(n + 2, 0);
+    for (int v = 0; v < n; v++) {
+        graph.forEachNeighbor(v, [&rev](int u, int) {
+            rev.offsets[u + 2]++;
+            return true;
+        });
+    }
+    for (int v = 0; v < n; v++) { rev.offsets[v + 2] += rev.offsets[v + 1]; }
+    rev.sources.resize(rev.offsets[n + 1]);
+    rev.weights.resize(rev.offsets[n + 1]);
+    for (int v = 0; v < n; v++) {
+        graph.forEachNeighbor(v, [&rev, v](int u, int edgeWeight) {
+            long long slot = rev.offsets[u + 1]++;
+            rev.sources[slot] = v;
+            rev.weights[slot] = edgeWeight;
+            return true;
+        });
+    }
+    rev.offsets.pop_back();
+    return rev;
+}
+
+/** shortest-path tree to one vertex: cost to reach it and next hop */
+struct TreeToEnd {
+    std::vector<long long> cost;
+    std::vector<int> next;
+};
+
+/** A* work arrays for one worker, only touched entries are reset */
+struct SpurWorkspace {
+    std::vector<long long> cost;
+    std::vector<int> previous;
+    std::vector<char> banned;
+    std::vector<int> touched;
+
+    explicit SpurWorkspace(int n)
+        : cost(n, shortestpath::kUnreachable), previous(n, -1),
+          banned(n, 0) {}
+
+    void reset() {
+        for (int v : touched) {
+            cost[v] = shortestpath::kUnreachable;
+            previous[v] = -1;
+        }
+        touched.clear();
+    }
+};
+
+/** cheapest path from spur to endId that avoids ws.banned vertices and
+    the edges spur -> bannedNext; empty if there is none
+    costs start at spurCost */
+template <typename GraphView>
+CostedPath spurPath(const GraphView& graph, const TreeToEnd& tree,
+                    int spur, int endId, long long spurCost,
+                    const std::vector<int>& bannedNext, SpurWorkspace& ws) {
+    auto isBannedNext = [&bannedNext](int v) {
+        return std::find(bannedNext.begin(), bannedNext.end(), v) !=
+               bannedNext.end();
+    };
+    CostedPath path;
+    if (tree.cost[spur] == shortestpath::kUnreachable) { return path; }
+    // the tree path is the best possible, use it if nothing blocks it
+    bool treePathFree = spur == endId || !isBannedNext(tree.next[spur]);
+    for (int v = tree.next[spur]; treePathFree && v != -1; v = tree.next[v]) {
+        treePathFree = ws.banned[v] == 0;
+    }
+    if (treePathFree) {
+        for (int v = spur; v != -1; v = tree.next[v]) {
+            path.vertices.push_back(v);
+            path.costs.push_back(spurCost + tree.cost[spur] - tree.cost[v]);
+        }
+        return path;
+    }
+    // A* with the tree cost as the estimate of the remaining cost
+    using Entry = std::pair<long long, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+    ws.reset();
+    ws.cost[spur] = 0;
+    ws.touched.push_back(spur);
+    pq.push({tree.cost[spur], spur});
+    while (!pq.empty()) {
+        auto [estimate, v] = pq.top();
+        pq.pop();
+        if (estimate != ws.cost[v] + tree.cost[v]) { continue; }
+        if (v == endId) { break; }
+        graph.forEachNeighbor(v, [&](int u, int edgeWeight) {
+            if (ws.banned[u] != 0 || tree.cost[u] ==
+                shortestpath::kUnreachable || (v == spur && isBannedNext(u))) {
+                return true;
+            }
+            long long viaV = ws.cost[v] + edgeWeight;
+            if (viaV < ws.cost[u]) {
+                if (ws.cost[u] == shortestpath::kUnreachable) {
+                    ws.touched.push_back(u);
+                }
+                ws.cost[u] = viaV;
+                ws.previous[u] = v;
+                pq.push({viaV + tree.cost[u], u});
+            }
+            return true;
+        });
+    }
+    if (ws.cost[endId] == shortestpath::kUnreachable) { return path; }
+    for (int v = endId; v != -1; v = ws.previous[v]) {
+        path.vertices.push_back(v);
+        path.costs.push_back(spurCost + ws.cost[v]);
+    }
+    std::reverse(path.vertices.begin(), path.vertices.end());
+    std::reverse(path.costs.begin(), path.costs.end());
+    return path;
+}
+
+}  // namespace detail
+
+/** the k cheapest loopless paths from startId to endId, cheapest first
+    fewer if there are not k of them, empty if endId cannot be reached
+    the spur searches of each round run on pool if given */
+template <typename GraphView>
+std::vector<Path> yen(const GraphView& graph, int startId, int endId, int k,
+                      ThreadPool* pool = nullptr) {
+    using detail::CostedPath;
+    std::vector<Path> result;
+    int n = graph.getNumVertices();
+    if (k <= 0) { return result; }
+    // one tree to the end vertex, shared by every spur search
+    detail::TreeToEnd tree;
+    shortestpath::dijkstra(detail::reverse(graph), endId, tree.cost,
+                           tree.next);
+    // a cycle back to the end is no step on a path to it
+    tree.next[endId] = -1;
+    if (tree.cost[startId] == shortestpath::kUnreachable) { return result; }
+    // one workspace per pool worker, the last for the calling thread
+    std::vector<detail::SpurWorkspace> workspaces;
+    int numWorkers = pool == nullptr ? 0 : pool->getNumThreads();
+    for (int w = 0; w <= numWorkers; w++) { workspaces.emplace_back(n); }
+
+    std::vector<CostedPath> found;
+    found.push_back(detail::spurPath(graph, tree, startId, endId, 0, {},
+                                     workspaces[numWorkers]));
+    std::set<CostedPath> candidates;
+    std::set<std::vector<int>> seen {found[0].vertices};
+    while (static_cast<int>(found.size()) < k) {
+        const CostedPath& last = found.back();
+        int numSpurs = static_cast<int>(last.vertices.size()) - 1;
+        std::vector<CostedPath> spurs(numSpurs);
+        // spur i leaves the last path at its i-th vertex
+        auto runSpurs = [&](long long first, long long lastSpur) {
+            int worker = pool == nullptr ? -1 : pool->currentWorker();
+            detail::SpurWorkspace& ws =
+                workspaces[worker == -1 ? numWorkers : worker];
+            for (int i = static_cast<int>(first); i < lastSpur; i++) {
+                int spur = last.vertices[i];
+                std::vector<int> bannedNext;
+                for (const CostedPath& p : found) {
+                    if (static_cast<int>(p.vertices.size()) > i + 1 &&
+                        std::equal(p.vertices.begin(),
+                                   p.vertices.begin() + i + 1,
+                                   last.vertices.begin())) {
+                        bannedNext.push_back(p.vertices[i + 1]);
+                    }
+                }
+                for (int r = 0; r < i; r++) {
+                    ws.banned[last.vertices[r]] = 1;
+                }
+                CostedPath spurPath = detail::spurPath(
+                    graph, tree, spur, endId, last.costs[i], bannedNext, ws);
+                for (int r = 0; r < i; r++) {
+                    ws.banned[last.vertices[r]] = 0;
+                }
+                if (spurPath.vertices.empty()) { continue; }
+                CostedPath& candidate = spurs[i];
+                candidate.vertices.assign(last.vertices.begin(),
+                                          last.vertices.begin() + i);
+                candidate.costs.assign(last.costs.begin(),
+                                       last.costs.begin() + i);
+                candidate.vertices.insert(candidate.vertices.end(),
+                                          spurPath.vertices.begin(),
+                                          spurPath.vertices.end());
+                candidate.costs.insert(candidate.costs.end(),
+                                       spurPath.costs.begin(),
+                                       spurPath.costs.end());
+            }
+        };
+        if (pool == nullptr || numSpurs == 1) {
+            runSpurs(0, numSpurs);
+        } else {
+            pool->parallelFor(0, numSpurs, 1, runSpurs);
+        }
+        for (CostedPath& candidate : spurs) {
+            if (!candidate.vertices.empty() &&
+                seen.insert(candidate.vertices).second) {
+                candidates.insert(std::move(candidate));
+            }
+        }
+        if (candidates.empty()) { break; }
+        found.push_back(*candidates.begin());
+        candidates.erase(candidates.begin());
+    }
+    for (const CostedPath& p : found) {
+        result.push_back(Path{p.vertices, p.cost()});
+    }
+    return result;
+}
+
+/** the k cheapest loopless paths from start to end by label
+    empty if either vertex does not exist */
+template <typename GraphView>
+std::vector<LabeledPath> yen(const GraphView& graph, const std::string& start,
+                             const std::string& end, int k,
+                             ThreadPool* pool = nullptr) {
+    std::vector<LabeledPath> result;
+    int startId = graph.findId(start);
+    int endId = graph.findId(end);
+    if (startId == -1 || endId == -1) { return result; }
+    for (const Path& p : yen(graph, startId, endId, k, pool)) {
+        LabeledPath labeled;
+        for (int v : p.vertices) {
+            labeled.vertices.push_back(graph.getLabel(v));
+        }
+        labeled.cost = p.cost;
+        result.push_back(std::move(labeled));
+    }
+    return result;
+}
+
+}  // namespace kshortestpaths
+
+#endif  // KSHORTESTPATHS_H
@@ -0,0 +1,241 @@
+/**
+ * Open addressing hash map from vertex labels to values
+ * Used in place of std::map when neighbor order does not matter
+ * Swiss table layout: a control byte per slot holding 7 bits of the hash,
+ * probed 16 slots at a time, so most misses never compare a string
+ * Entries are stored densely in insertion order with their hash,
+ * growing never rehashes a label
+ * erase moves the last entry into the hole, changing iteration order
+ */
+
+#ifndef LABELHASHMAP_H
+#define LABELHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+template <typename V>
+class LabelHashMap {
+ public:
+    /** entry named like std::map's value_type so code can walk either */
+    struct Entry {
+        std::string first;
+        V second;
+        size_t hash;
+    };
+
+    /** hash used for labels, callers can compute it once and reuse it */
+    static size_t hashLabel(const std::string& label) {
+        size_t h = std::hash<std::string>{}(label);
+        // std::hash may be the identity on some platforms, mix the bits
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /** return number of entries */
+    int size() const { return static_cast<int>(entries.size()); }
+
+    /** return true if there are no entries */
+    bool empty() const { return entries.empty(); }
+
+    /** remove all entries */
+    void clear() {
+        entries.clear();
+        control.clear();
+        slots.clear();
+        tombstones = 0;
+    }
+
+    /** make room for n entries without rehashing */
+    void reserve(int n) {
+        entries.reserve(n);
+        size_t needed = kGroupSize;
+        while (needed * 7 / 8 < static_cast<size_t>(n) + 1) { needed *= 2; }
+        if (needed > control.size()) { rehash(needed); }
+    }
+
+    /** return pointer to value for key, nullptr if not found */
+    V* find(const std::string& key) { return find(key, hashLabel(key)); }
+
+    /** return pointer to value for key, nullptr if not found */
+    const V* find(const std::string& key) const {
+        return find(key, hashLabel(key));
+    }
+
+    /** find with a precomputed hash */
+    V* find(const std::string& key, size_t hash) {
+        int index = findIndex(key, hash);
+        return index == -1 ? nullptr : &entries[index].second;
+    }
+
+    /** find with a precomputed hash */
+    const V* find(const std::string& key, size_t hash) const {
+        int index = findIndex(key, hash);
+        return index == -1 ? nullptr : &entries[index].second;
+    }
+
+    /** insert key if not already there
+        returns the stored value and true if it was inserted */
+    std::pair<V*, bool> insert(const std::string& key, V value) {
+        return insert(key, hashLabel(key), std::move(value));
+    }
+
+    /** insert with a precomputed hash */
+    std::pair<V*, bool> insert(const std::string& key, size_t hash,
+                               V value) {
+        int index = findIndex(key, hash);
+        if (index != -1) { return {&entries[index].second, false}; }
+        if ((entries.size() + tombstones + 1) * 8 > control.size() * 7) {
+            // at most 7/16 full after a rehash, tombstones are dropped
+            size_t capacity = kGroupSize;
+            while (capacity * 7 / 16 < entries.size() + 1) { capacity *= 2; }
+            rehash(capacity);
+        }
+        size_t slot = findFreeSlot(hash);
+        if (control[slot] == kDeleted) { tombstones--; }
+        control[slot] = h2(hash);
+        slots[slot] = static_cast<uint32_t>(entries.size());
+        entries.push_back(Entry{key, std::move(value), hash});
+        return {&entries.back().second, true};
+    }
+
+    /** remove key, return true if it was there */
+    bool erase(const std::string& key) {
+        size_t hash = hashLabel(key);
+        size_t slot = findSlot(key, hash);
+        if (slot == kNotFound) { return false; }
+        uint32_t index = slots[slot];
+        control[slot] = kDeleted;
+        tombstones++;
+        uint32_t last = static_cast<uint32_t>(entries.size() - 1);
+        if (index != last) {
+            // move the last entry into the hole and repoint its slot
+            size_t lastSlot = findSlot(entries[last].first,
+                                       entries[last].hash);
+            slots[lastSlot] = index;
+            entries[index] = std::move(entries[last]);
+        }
+        entries.pop_back();
+        return true;
+    }
+
+    /** return the i-th entry in iteration order */
+    const Entry& entryAt(int i) const { return entries[i]; }
+
+    /** iterate entries in insertion order */
+    typename std::vector<Entry>::const_iterator begin() const {
+        return entries.begin();
+    }
+
+    /** iterate entries in insertion order */
+    typename std::vector<Entry>::const_iterator end() const {
+        return entries.end();
+    }
+
+ private:
+    /** slots probed together */
+    static constexpr size_t kGroupSize = 16;
+
+    /** control byte of a slot never used */
+    static constexpr uint8_t kEmpty = 0x80;
+
+    /** control byte of a slot whose entry was erased */
+    static constexpr uint8_t kDeleted = 0xFE;
+
+    /** findSlot result when the key is missing */
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+    /** low 7 bits of the hash, stored in the control byte */
+    static uint8_t h2(size_t hash) { return hash & 0x7F; }
+
+    /** bit mask of slots in the group at start whose control byte is b */
+    uint32_t matchByte(size_t start, uint8_t b) const {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(&control[start]));
+        return static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(b)))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupSize; ++i) {
+            if (control[start + i] == b) { mask |= 1u << i; }
+        }
+        return mask;
+#endif
+    }
+
+    /** slot holding key, kNotFound if missing */
+    size_t findSlot(const std::string& key, size_t hash) const {
+        if (control.empty()) { return kNotFound; }
+        size_t numGroups = control.size() / kGroupSize;
+        size_t group = (hash >> 7) & (numGroups - 1);
+        for (size_t probe = 1; probe <= numGroups; ++probe) {
+            size_t start = group * kGroupSize;
+            for (uint32_t m = matchByte(start, h2(hash)); m != 0;
+                 m &= m - 1) {
+                size_t slot = start + __builtin_ctz(m);
+                const Entry& entry = entries[slots[slot]];
+                if (entry.hash == hash && entry.first == key) {
+                    return slot;
+                }
+            }
+            if (matchByte(start, kEmpty) != 0) { return kNotFound; }
+            group = (group + probe) & (numGroups - 1);
+        }
+        return kNotFound;
+    }
+
+    /** index in entries of key, -1 if missing */
+    int findIndex(const std::string& key, size_t hash) const {
+        size_t slot = findSlot(key, hash);
+        return slot == kNotFound ? -1 : static_cast<int>(slots[slot]);
+    }
+
+    /** first empty or deleted slot on the probe sequence of hash */
+    size_t findFreeSlot(size_t hash) const {
+        size_t numGroups = control.size() / kGroupSize;
+        size_t group = (hash >> 7) & (numGroups - 1);
+        for (size_t probe = 1;; ++probe) {
+            size_t start = group * kGroupSize;
+            uint32_t m = matchByte(start, kEmpty) | matchByte(start, kDeleted);
+            if (m != 0) { return start + __builtin_ctz(m); }
+            group = (group + probe) & (numGroups - 1);
+        }
+    }
+
+    /** rebuild the control bytes for capacity slots, dropping tombstones */
+    void rehash(size_t capacity) {
+        control.assign(capacity, kEmpty);
+        slots.assign(capacity, 0);
+        tombstones = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            size_t slot = findFreeSlot(entries[i].hash);
+            control[slot] = h2(entries[i].hash);
+            slots[slot] = static_cast<uint32_t>(i);
+        }
+    }
+
+    /** entries in insertion order */
+    std::vector<Entry> entries;
+
+    /** one control byte per slot, size is a power of two */
+    std::vector<uint8_t> control;
+
+    /** index into entries for each full slot */
+    std::vector<uint32_t> slots;
+
+    /** number of deleted slots */
+    size_t tombstones {0};
+};  // end LabelHashMap
+
+#endif  // LABELHASHMAP_H
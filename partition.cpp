@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "partition.h"
+
+/**
+ * Splits a graph into shards with few edges between them
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+/** stop coarsening once a level has this many vertices per shard */
+const int kCoarsestPerShard = 20;
+
+/** refinement passes per level */
+const int kRefinePasses = 8;
+
+/** undirected graph at one level of coarsening
+    edge weights count the edges merged into each edge,
+    vertex weights count the original vertices merged into each vertex */
+struct Level {
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<int> edgeWeights;
+    std::vector<int> vertexWeights;
+
+    int size() const { return static_cast<int>(vertexWeights.size()); }
+};
+
+/** graph as an undirected level, A->B and B->A become one edge of weight 2 */
+Level undirected(const Graph& graph) {
+    int n = graph.getNumVertices();
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(2 * static_cast<size_t>(graph.getNumEdges()));
+    for (int v = 0; v < n; v++) {
+        graph.forEachNeighbor(v, [&edges, v](int u, int) {
+            edges.emplace_back(v, u);
+            edges.emplace_back(u, v);
+            return true;
+        });
+    }
+    std::sort(edges.begin(), edges.end());
+    Level level;
+    level.vertexWeights.assign(n, 1);
+    level.offsets.assign(n + 1, 0);
+    for (size_t i = 0; i < edges.size(); i++) {
+        if (i > 0 && edges[i] == edges[i - 1]) {
+            level.edgeWeights.back()++;
+            continue;
+        }
+        level.targets.push_back(edges[i].second);
+        level.edgeWeights.push_back(1);
+        level.offsets[edges[i].first + 1]++;
+    }
+    std::partial_sum(level.offsets.begin(), level.offsets.end(),
+                     level.offsets.begin());
+    return level;
+}
+
+/** merge each vertex with its heaviest unmatched neighbor
+    coarseOf maps each fine vertex to its coarse vertex */
+Level coarsen(const Level& fine, std::vector<int>& coarseOf) {
+    int n = fine.size();
+    // match low degree vertices first, they have the fewest choices
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&fine](int a, int b) {
+        return fine.offsets[a + 1] - fine.offsets[a] <
+               fine.offsets[b + 1] - fine.offsets[b];
+    });
+    coarseOf.assign(n, -1);
+    int numCoarse = 0;
+    for (int v : order) {
+        if (coarseOf[v] != -1) { continue; }
+        int best = -1;
+        int bestWeight = 0;
+        for (int i = fine.offsets[v]; i < fine.offsets[v + 1]; i++) {
+            int u = fine.targets[i];
+            if (coarseOf[u] == -1 && fine.edgeWeights[i] > bestWeight) {
+                best = u;
+                bestWeight = fine.edgeWeights[i];
+            }
+        }
+        coarseOf[v] = numCoarse;
+        if (best != -1) { coarseOf[best] = numCoarse; }
+        numCoarse++;
+    }
+    // members of each coarse vertex
+    std::vector<int> memberOffsets(numCoarse + 1, 0);
+    for (int v = 0; v < n; v++) { memberOffsets[coarseOf[v] + 1]++; }
+    std::partial_sum(memberOffsets.begin(), memberOffsets.end(),
+                     memberOffsets.begin());
+    std::vector<int> members(n);
+    std::vector<int> fill(memberOffsets.begin(), memberOffsets.end() - 1);
+    for (int v = 0; v < n; v++) { members[fill[coarseOf[v]]++] = v; }
+
+    Level coarse;
+    coarse.vertexWeights.assign(numCoarse, 0);
+    coarse.offsets.assign(numCoarse + 1, 0);
+    // slot[c] is where edge to c sits in the current vertex's list
+    std::vector<int> slot(numCoarse, -1);
+    for (int c = 0; c < numCoarse; c++) {
+        int first = static_cast<int>(coarse.targets.size());
+        for (int m = memberOffsets[c]; m < memberOffsets[c + 1]; m++) {
+            int v = members[m];
+            coarse.vertexWeights[c] += fine.vertexWeights[v];
+            for (int i = fine.offsets[v]; i < fine.offsets[v + 1]; i++) {
+                int target = coarseOf[fine.targets[i]];
+                if (target == c) { continue; }
+                if (slot[target] == -1) {
+                    slot[target] = static_cast<int>(coarse.targets.size());
+                    coarse.targets.push_back(target);
+                    coarse.edgeWeights.push_back(0);
+                }
+                coarse.edgeWeights[slot[target]] += fine.edgeWeights[i];
+            }
+        }
+        for (size_t i = first; i < coarse.targets.size(); i++) {
+            slot[coarse.targets[i]] = -1;
+        }
+        coarse.offsets[c + 1] = static_cast<int>(coarse.targets.size());
+    }
+    return coarse;
+}
+
+/** first split: grow shards 0 .. numShards - 2 breadth-first up to their
+    share of the weight, whatever is left goes to the last shard */
+std::vector<int> grow(const Level& level, int numShards) {
+    int n = level.size();
+    long long total = std::accumulate(level.vertexWeights.begin(),
+                                      level.vertexWeights.end(), 0LL);
+    std::vector<int> part(n, -1);
+    int nextSeed = 0;
+    long long assigned = 0;
+    for (int p = 0; p < numShards - 1; p++) {
+        // share of what is left, so rounding does not starve the last shard
+        long long target = (total - assigned) / (numShards - p);
+        long long weight = 0;
+        std::vector<int> queue;
+        size_t head = 0;
+        while (weight < target) {
+            if (head == queue.size()) {
+                while (nextSeed < n && part[nextSeed] != -1) { nextSeed++; }
+                if (nextSeed == n) { break; }
+                queue.push_back(nextSeed);
+            }
+            int v = queue[head++];
+            if (part[v] != -1) { continue; }
+            part[v] = p;
+            weight += level.vertexWeights[v];
+            for (int i = level.offsets[v]; i < level.offsets[v + 1]; i++) {
+                if (part[level.targets[i]] == -1) {
+                    queue.push_back(level.targets[i]);
+                }
+            }
+        }
+        assigned += weight;
+    }
+    for (int& p : part) {
+        if (p == -1) { p = numShards - 1; }
+    }
+    return part;
+}
+
+/** move vertices to the neighboring shard they have most edges to,
+    as long as the cut shrinks and no shard grows over maxWeight
+    vertices in overweight shards move even if the cut grows */
+void refine(const Level& level, std::vector<int>& part, int numShards,
+            long long maxWeight) {
+    int n = level.size();
+    std::vector<long long> shardWeight(numShards, 0);
+    for (int v = 0; v < n; v++) {
+        shardWeight[part[v]] += level.vertexWeights[v];
+    }
+    std::vector<int> connection(numShards, 0);
+    std::vector<int> touched;
+    for (int pass = 0; pass < kRefinePasses; pass++) {
+        int moved = 0;
+        for (int v = 0; v < n; v++) {
+            int p = part[v];
+            int w = level.vertexWeights[v];
+            for (int i = level.offsets[v]; i < level.offsets[v + 1]; i++) {
+                int q = part[level.targets[i]];
+                if (connection[q] == 0) { touched.push_back(q); }
+                connection[q] += level.edgeWeights[i];
+            }
+            bool overweight = shardWeight[p] > maxWeight;
+            int best = -1;
+            int bestGain = overweight ? INT_MIN : 0;
+            for (int q : touched) {
+                if (q == p || shardWeight[q] + w > maxWeight) { continue; }
+                int gain = connection[q] - connection[p];
+                // equal cut: only move if it evens out the shards
+                bool better = gain > bestGain ||
+                    (gain == bestGain && best == -1 && !overweight &&
+                     shardWeight[q] + w < shardWeight[p]);
+                if (better) {
+                    best = q;
+                    bestGain = gain;
+                }
+            }
+            if (best == -1 && overweight) {
+                // nothing adjacent has room, take the lightest shard
+                int lightest = static_cast<int>(
+                    std::min_element(shardWeight.begin(), shardWeight.end()) -
+                    shardWeight.begin());
+                if (shardWeight[lightest] + w <= maxWeight) { best = lightest; }
+            }
+            for (int q : touched) { connection[q] = 0; }
+            touched.clear();
+            if (best != -1) {
+                part[v] = best;
+                shardWeight[p] -= w;
+                shardWeight[best] += w;
+                moved++;
+            }
+        }
+        if (moved == 0) { break; }
+    }
+}
+
+}  // namespace
+
+/** split graph into numShards shards of about equal size */
+Partition partitionGraph(const Graph& graph, int numShards,
+                         double imbalance) {
+    Partition result;
+    result.numShards = std::max(1, numShards);
+    int n = graph.getNumVertices();
+    if (result.numShards == 1 || n == 0) {
+        result.shardOf.assign(n, 0);
+        return result;
+    }
+    std::vector<Level> levels;
+    std::vector<std::vector<int>> coarseOf;
+    levels.push_back(undirected(graph));
+    while (levels.back().size() > kCoarsestPerShard * result.numShards) {
+        std::vector<int> map;
+        Level coarse = coarsen(levels.back(), map);
+        // matching has stalled, coarsening further will not help
+        if (coarse.size() * 20 > levels.back().size() * 19) { break; }
+        levels.push_back(std::move(coarse));
+        coarseOf.push_back(std::move(map));
+    }
+    long long maxWeight = static_cast<long long>(
+        std::ceil((1.0 + imbalance) * n / result.numShards));
+    std::vector<int> part = grow(levels.back(), result.numShards);
+    refine(levels.back(), part, result.numShards, maxWeight);
+    for (int l = static_cast<int>(levels.size()) - 2; l >= 0; l--) {
+        std::vector<int> finePart(levels[l].size());
+        for (int v = 0; v < levels[l].size(); v++) {
+            finePart[v] = part[coarseOf[l][v]];
+        }
+        part = std::move(finePart);
+        refine(levels[l], part, result.numShards, maxWeight);
+    }
+    result.shardOf = std::move(part);
+    for (int v = 0; v < n; v++) {
+        graph.forEachNeighbor(v, [&result, v](int u, int) {
+            if (result.shardOf[u] != result.shardOf[v]) { result.cutEdges++; }
+            return true;
+        });
+    }
+    return result;
+}
@@ -0,0 +1,34 @@
+/**
+ * Splits a graph into shards with few edges between them
+ * Multilevel, in the style of METIS: the graph is treated as undirected,
+ * repeatedly coarsened by merging the ends of heavy edges, split on the
+ * coarsest level by growing shards breadth-first, and the split is then
+ * projected back level by level with greedy boundary refinement
+ */
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <vector>
+
+#include "graph.h"
+
+/** which shard each vertex belongs to */
+struct Partition {
+    /** number of shards */
+    int numShards {0};
+
+    /** shard of each vertex, by vertex ID */
+    std::vector<int> shardOf;
+
+    /** number of directed edges whose ends are in different shards */
+    int cutEdges {0};
+};
+
+/** split graph into numShards shards of about equal size
+    no shard gets more than (1 + imbalance) times its share of vertices,
+    unless a single merged vertex is already bigger */
+Partition partitionGraph(const Graph& graph, int numShards,
+                         double imbalance = 0.03);
+
+#endif  // PARTITION_H
@@ -0,0 +1,148 @@
+#include <atomic>
+
+#include "cpufeatures.h"
+#include "relaxkernel.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RELAXKERNEL_X86 1
+#include <immintrin.h>
+#else
+#define RELAXKERNEL_X86 0
+#endif
+
+/**
+ * Edge relaxation over flat adjacency arrays
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace relaxkernel {
+
+namespace {
+
+/** plain loop over edges [first, count), appending without a branch */
+int relaxScalar(long long base, const int* targets, const int* weights,
+                int first, int count, const long long* cost, int* improved) {
+    int found = 0;
+    for (int i = first; i < count; i++) {
+        improved[found] = i;
+        found += base + weights[i] < cost[targets[i]] ? 1 : 0;
+    }
+    return found;
+}
+
+#if RELAXKERNEL_X86
+
+/** four edges at a time */
+__attribute__((target("avx2")))
+int relaxAvx2(long long base, const int* targets, const int* weights,
+              int count, const long long* cost, int* improved) {
+    const __m256i vertexCost = _mm256_set1_epi64x(base);
+    int found = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i ids = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(targets + i));
+        __m256i current = _mm256_i32gather_epi64(cost, ids, 8);
+        __m256i candidate = _mm256_add_epi64(vertexCost,
+            _mm256_cvtepi32_epi64(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(weights + i))));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_cmpgt_epi64(current, candidate)));
+        while (mask != 0) {
+            improved[found++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    return found + relaxScalar(base, targets, weights, i, count, cost,
+                               improved + found);
+}
+
+/** eight edges at a time */
+__attribute__((target("avx512f")))
+int relaxAvx512(long long base, const int* targets, const int* weights,
+                int count, const long long* cost, int* improved) {
+    const __m512i vertexCost = _mm512_set1_epi64(base);
+    int found = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i ids = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(targets + i));
+        // masked forms with every lane on: the unmasked ones trip a false
+        // uninitialized warning in some compiler headers
+        __m512i current = _mm512_mask_i32gather_epi64(
+            _mm512_setzero_si512(), 0xFF, ids, cost, 8);
+        __m512i candidate = _mm512_add_epi64(vertexCost,
+            _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(weights + i))));
+        unsigned mask = _mm512_cmplt_epi64_mask(candidate, current);
+        while (mask != 0) {
+            improved[found++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    return found + relaxScalar(base, targets, weights, i, count, cost,
+                               improved + found);
+}
+
+#endif  // RELAXKERNEL_X86
+
+/** widest kernel the CPU supports */
+Kernel detectKernel() {
+    if (isSupported(Kernel::Avx512)) { return Kernel::Avx512; }
+    if (isSupported(Kernel::Avx2)) { return Kernel::Avx2; }
+    return Kernel::Scalar;
+}
+
+/** kernel relaxEdges dispatches to */
+std::atomic<Kernel> activeKernel {detectKernel()};
+
+}  // namespace
+
+/** return true if this CPU and build can run kernel */
+bool isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Avx512:
+            return cpufeatures::has(cpufeatures::Feature::Avx512f);
+        case Kernel::Avx2:
+            return cpufeatures::has(cpufeatures::Feature::Avx2);
+        case Kernel::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** return the kernel relaxEdges uses */
+Kernel getKernel() {
+    return activeKernel.load(std::memory_order_relaxed);
+}
+
+/** make relaxEdges use kernel */
+bool setKernel(Kernel kernel) {
+    if (!isSupported(kernel)) { return false; }
+    activeKernel.store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+/** store the edges that improve a neighbor's cost in improved */
+int relaxEdges(long long base, const int* targets, const int* weights,
+               int count, const long long* cost, int* improved) {
+    switch (getKernel()) {
+#if RELAXKERNEL_X86
+        case Kernel::Avx512:
+            return relaxAvx512(base, targets, weights, count, cost, improved);
+        case Kernel::Avx2:
+            return relaxAvx2(base, targets, weights, count, cost, improved);
+#endif
+        default:
+            return relaxScalar(base, targets, weights, 0, count, cost,
+                               improved);
+    }
+}
+
+}  // namespace relaxkernel
@@ -0,0 +1,40 @@
+/**
+ * Edge relaxation over flat adjacency arrays, the inner loop of the
+ * shortest-path searches in shortestpath.h
+ * For the edges of one vertex it looks up each neighbor's current cost,
+ * adds the edge weight to the vertex's cost and reports which edges
+ * would make a neighbor cheaper. The AVX2 and AVX-512 versions gather
+ * four or eight neighbor costs at a time; the version used is picked at
+ * run time from what the CPU supports, with a plain loop as fallback
+ * The kernel only reads costs, the caller applies the improvements
+ */
+
+#ifndef RELAXKERNEL_H
+#define RELAXKERNEL_H
+
+namespace relaxkernel {
+
+/** implementations of relaxEdges */
+enum class Kernel { Scalar, Avx2, Avx512 };
+
+/** return true if this CPU and build can run kernel */
+bool isSupported(Kernel kernel);
+
+/** return the kernel relaxEdges uses, the widest supported by default */
+Kernel getKernel();
+
+/** make relaxEdges use kernel, for testing and benchmarks
+    returns false and changes nothing if kernel is not supported */
+bool setKernel(Kernel kernel);
+
+/** for each edge i in [0, count), store i in improved if
+    base + weights[i] < cost[targets[i]]
+    improved must have room for count entries, they come out in order
+    base must be below the largest long long minus the largest weight
+    returns the number of entries stored */
+int relaxEdges(long long base, const int* targets, const int* weights,
+               int count, const long long* cost, int* improved);
+
+}  // namespace relaxkernel
+
+#endif  // RELAXKERNEL_H
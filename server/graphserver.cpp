@@ -0,0 +1,468 @@
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../graph.h"
+#include "../shortestpathresult.h"
+#include "../threadpool.h"
+#include "../traversal.h"
+#include "queryprotocol.h"
+
+/**
+ * Graph query server: loads a graph file once and answers queries from
+ * many clients over a Unix domain socket, see queryprotocol.h
+ *
+ *     graphserver graphFile socketPath [threads]
+ *
+ * Each connection has a thread reading requests. Edge weights, labels
+ * and stats are answered there, as they are cheap; traversals and
+ * shortest paths go into a shared queue. A dispatcher takes everything
+ * waiting in the queue as one batch, so batches grow with the load. In a
+ * batch, shortest-path requests from the same start share one Dijkstra
+ * run, and the distinct starts and the traversals are spread over a
+ * ThreadPool. There is a dispatcher per pool thread, so while one waits
+ * for a slow request in its batch the others keep taking new batches
+ * Answers are queued on their connection as soon as they are ready,
+ * tagged with their request ID, so a client can keep many requests in
+ * flight on one connection. Each connection has a writer thread sending
+ * its queue, so no other thread ever waits on a client socket; a client
+ * that stops reading until kMaxQueuedBytes of answers pile up is cut off
+ * Latency, from reading a request to sending its answer, goes into a
+ * histogram per request type, sent back for Stats requests and printed
+ * when the server is stopped with SIGINT or SIGTERM
+ *
+ * Built with the library files, from the repository directory:
+ *     g++ -std=c++17 -O2 -pthread server/graphserver.cpp graph.cpp
+ *         vertex.cpp edge.cpp csrgraph.cpp threadpool.cpp relaxkernel.cpp
+ *         shortestpathresult.cpp -o graphserver
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using namespace queryprotocol;
+
+/** most requests taken as one batch */
+constexpr size_t kMaxBatch = 4096;
+
+/** names of the request types, by type */
+const char* const kTypeNames[] = {"", "bfs", "dfs", "shortest-path",
+                                  "edge-weight", "labels"};
+
+/** most bytes of answers a connection may have waiting to be sent */
+constexpr size_t kMaxQueuedBytes = 64u << 20;
+
+/** one client connection and the answers waiting to be sent on it */
+struct Connection {
+    int fd;
+
+    std::mutex outboxLock;
+    std::condition_variable outboxReady;
+    std::deque<std::vector<uint8_t>> outbox;
+    size_t queuedBytes {0};
+    /** requests read but not answered yet */
+    size_t unanswered {0};
+    /** set when the reader has seen the last request */
+    bool readerDone {false};
+    /** set when the client is gone or was cut off, answers are dropped */
+    bool closed {false};
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { ::close(fd); }
+
+    /** count a request read, to be answered later with send */
+    void expect() {
+        std::lock_guard<std::mutex> lock(outboxLock);
+        unanswered++;
+    }
+
+    /** queue the answer to one request, never waits for the client */
+    void send(const std::vector<uint8_t>& frame) {
+        {
+            std::lock_guard<std::mutex> lock(outboxLock);
+            unanswered--;
+            if (!closed && !outbox.empty() &&
+                queuedBytes + frame.size() > kMaxQueuedBytes) {
+                cutOff();
+            }
+            if (!closed) {
+                outbox.push_back(frame);
+                queuedBytes += frame.size();
+            }
+        }
+        outboxReady.notify_one();
+    }
+
+    /** no more requests will be read */
+    void finishReading() {
+        {
+            std::lock_guard<std::mutex> lock(outboxLock);
+            readerDone = true;
+        }
+        outboxReady.notify_one();
+    }
+
+    /** send queued answers until the client is gone, or has been sent
+        the answer to every request it made */
+    void writeLoop() {
+        std::vector<std::vector<uint8_t>> sending;
+        std::unique_lock<std::mutex> lock(outboxLock);
+        while (true) {
+            outboxReady.wait(lock, [this] {
+                return !outbox.empty() || closed ||
+                       (readerDone && unanswered == 0);
+            });
+            if (closed || outbox.empty()) { return; }
+            sending.assign(std::make_move_iterator(outbox.begin()),
+                           std::make_move_iterator(outbox.end()));
+            outbox.clear();
+            queuedBytes = 0;
+            lock.unlock();
+            bool sent = true;
+            for (const auto& frame : sending) {
+                if (sent) { sent = writeAll(fd, frame); }
+            }
+            sending.clear();
+            lock.lock();
+            if (!sent && !closed) { cutOff(); }
+        }
+    }
+
+    /** drop queued answers and hang up, called under outboxLock; the
+        reader sees the end of the stream and stops too */
+    void cutOff() {
+        closed = true;
+        outbox.clear();
+        queuedBytes = 0;
+        ::shutdown(fd, SHUT_RDWR);
+    }
+};
+
+/** a request waiting for an answer */
+struct Request {
+    std::shared_ptr<Connection> connection;
+    uint32_t id;
+    uint8_t type;
+    std::string start;
+    std::string end;
+    uint32_t limit;
+    Clock::time_point received;
+};
+
+/** everything the server shares between threads */
+struct Server {
+    Graph graph;
+    std::shared_ptr<const CsrGraph> csr;
+    std::unique_ptr<ThreadPool> pool;
+    /** one reusable result per pool worker, the last for other threads */
+    std::vector<ShortestPathResult> results;
+
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::vector<Request> queue;
+
+    LatencyHistogram latency[kNumTimedTypes + 1];
+};
+
+/** set by the signal handler */
+volatile sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+/** queue an answer and count its latency */
+void reply(Server& server, const Request& request, Writer& writer) {
+    request.connection->send(writer.finish());
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - request.received).count();
+    server.latency[request.type].add(static_cast<uint64_t>(micros));
+}
+
+/** start of an answer to request */
+Writer answer(const Request& request, Status status) {
+    Writer writer;
+    writer.putU32(request.id);
+    writer.putU8(status);
+    return writer;
+}
+
+/** answer a traversal, edge weight or labels request */
+void runSingle(Server& server, const Request& request) {
+    const CsrGraph& csr = *server.csr;
+    if (request.type == kLabels) {
+        Writer writer = answer(request, kOk);
+        uint32_t count = static_cast<uint32_t>(csr.getNumVertices());
+        if (request.limit != 0 && request.limit < count) {
+            count = request.limit;
+        }
+        writer.putU32(count);
+        for (uint32_t v = 0; v < count; v++) {
+            writer.putString(csr.getLabel(static_cast<int>(v)));
+        }
+        reply(server, request, writer);
+        return;
+    }
+    int startId = csr.findId(request.start);
+    if (startId == -1) {
+        Writer writer = answer(request, kNotFound);
+        reply(server, request, writer);
+        return;
+    }
+    Writer writer = answer(request, kOk);
+    if (request.type == kEdgeWeight) {
+        writer.putI32(server.graph.getEdgeWeight(request.start, request.end));
+        reply(server, request, writer);
+        return;
+    }
+    std::vector<int> order;
+    auto visit = [&order, &request](const VertexHandle<CsrGraph>& v) {
+        order.push_back(v.getId());
+        return request.limit == 0 || order.size() < request.limit;
+    };
+    if (request.type == kBfs) {
+        traversal::breadthFirst(csr, startId, visit);
+    } else {
+        traversal::depthFirst(csr, startId, visit);
+    }
+    writer.putU32(static_cast<uint32_t>(order.size()));
+    for (int v : order) { writer.putString(csr.getLabel(v)); }
+    reply(server, request, writer);
+}
+
+/** answer shortest-path requests that share a start with one search */
+void runShortestPaths(Server& server, const std::vector<Request*>& group) {
+    const std::string& start = group.front()->start;
+    int worker = server.pool->currentWorker();
+    ShortestPathResult& result =
+        server.results[worker == -1 ? server.results.size() - 1 : worker];
+    server.graph.djikstraCostToAllVertices(start, result);
+    for (const Request* request : group) {
+        int endId = result.findId(request->end);
+        if (result.getStartId() == -1 || endId == -1) {
+            Writer writer = answer(*request, kNotFound);
+            reply(server, *request, writer);
+            continue;
+        }
+        Writer writer = answer(*request, kOk);
+        std::vector<int> path = result.getPathIds(endId);
+        writer.putI64(path.empty() ? -1 : result.getCost(endId));
+        writer.putU32(static_cast<uint32_t>(path.size()));
+        for (int v : path) { writer.putString(result.getLabel(v)); }
+        reply(server, *request, writer);
+    }
+}
+
+/** run one batch of requests on the pool */
+void runBatch(Server& server, std::vector<Request>& batch) {
+    // shortest paths grouped by start, the rest one by one
+    std::unordered_map<std::string, size_t> groupOf;
+    std::vector<std::vector<Request*>> groups;
+    std::vector<Request*> singles;
+    for (Request& request : batch) {
+        if (request.type != kShortestPath) {
+            singles.push_back(&request);
+            continue;
+        }
+        auto [it, inserted] = groupOf.emplace(request.start, groups.size());
+        if (inserted) { groups.emplace_back(); }
+        groups[it->second].push_back(&request);
+    }
+    long long numGroups = static_cast<long long>(groups.size());
+    long long total = numGroups + static_cast<long long>(singles.size());
+    server.pool->parallelFor(0, total, 1, [&](long long first,
+                                              long long last) {
+        for (long long i = first; i < last; i++) {
+            if (i < numGroups) {
+                runShortestPaths(server, groups[i]);
+            } else {
+                runSingle(server, *singles[i - numGroups]);
+            }
+        }
+    });
+}
+
+/** take batches from the queue until the server stops
+    runs on several threads, each waiting only for its own batches */
+void dispatch(Server& server) {
+    std::vector<Request> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(server.queueLock);
+            server.queueReady.wait(lock, [&server] {
+                return !server.queue.empty();
+            });
+            if (server.queue.size() <= kMaxBatch) {
+                batch.swap(server.queue);
+            } else {
+                auto split = server.queue.begin() + kMaxBatch;
+                batch.assign(std::make_move_iterator(server.queue.begin()),
+                             std::make_move_iterator(split));
+                server.queue.erase(server.queue.begin(), split);
+            }
+        }
+        runBatch(server, batch);
+        batch.clear();
+    }
+}
+
+/** answer a Stats request with every histogram */
+void sendStats(Server& server, const Request& request) {
+    Writer writer = answer(request, kOk);
+    for (int type = kBfs; type <= kNumTimedTypes; type++) {
+        const LatencyHistogram& histogram = server.latency[type];
+        writer.putU64(histogram.count.load(std::memory_order_relaxed));
+        for (int b = 0; b < kBuckets; b++) {
+            writer.putU64(histogram.buckets[b].load(std::memory_order_relaxed));
+        }
+    }
+    request.connection->send(writer.finish());
+}
+
+/** read requests from one client until it hangs up */
+void serveConnection(Server& server, std::shared_ptr<Connection> connection) {
+    std::thread(&Connection::writeLoop, connection).detach();
+    std::vector<uint8_t> frame;
+    while (readFrame(connection->fd, frame)) {
+        connection->expect();
+        Reader reader(frame);
+        Request request {connection, reader.getU32(), reader.getU8(), "", "",
+                         0, Clock::now()};
+        bool known = true;
+        switch (request.type) {
+            case kBfs:
+            case kDfs:
+                request.start = reader.getString();
+                request.limit = reader.getU32();
+                break;
+            case kShortestPath:
+            case kEdgeWeight:
+                request.start = reader.getString();
+                request.end = reader.getString();
+                break;
+            case kLabels:
+                request.limit = reader.getU32();
+                break;
+            case kStats:
+                break;
+            default:
+                known = false;
+        }
+        if (!known || !reader.ok() || !reader.atEnd()) {
+            Writer writer = answer(request, kBadRequest);
+            connection->send(writer.finish());
+            continue;
+        }
+        if (request.type == kStats) {
+            sendStats(server, request);
+            continue;
+        }
+        if (request.type == kEdgeWeight || request.type == kLabels) {
+            runSingle(server, request);
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(server.queueLock);
+            server.queue.push_back(std::move(request));
+        }
+        server.queueReady.notify_one();
+    }
+    connection->finishReading();
+}
+
+/** print count and percentiles of each histogram */
+void printStats(const Server& server) {
+    for (int type = kBfs; type <= kNumTimedTypes; type++) {
+        const LatencyHistogram& histogram = server.latency[type];
+        std::cout << kTypeNames[type] << ": "
+                  << histogram.count.load(std::memory_order_relaxed)
+                  << " requests, p50 < " << histogram.percentile(0.50)
+                  << " us, p99 < " << histogram.percentile(0.99) << " us"
+                  << std::endl;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0]
+                  << " graphFile socketPath [threads]" << std::endl;
+        return 2;
+    }
+    std::string socketPath = argv[2];
+    int numThreads = argc > 3 ? std::atoi(argv[3])
+                              : static_cast<int>(
+                                    std::thread::hardware_concurrency());
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "socket path too long" << std::endl;
+        return 2;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    Server server;
+    server.graph.readFile(argv[1]);
+    server.csr = server.graph.getCsrView();
+    server.pool = std::make_unique<ThreadPool>(numThreads);
+    server.results.resize(server.pool->getNumThreads() + 1);
+    std::cout << "loaded " << server.graph.getNumVertices() << " vertices, "
+              << server.graph.getNumEdges() << " edges" << std::endl;
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str());
+    if (listener == -1 ||
+        ::bind(listener, reinterpret_cast<sockaddr*>(&address),
+               sizeof(address)) == -1 ||
+        ::listen(listener, 128) == -1) {
+        std::perror("graphserver");
+        return 1;
+    }
+    // no SA_RESTART, so accept returns when a signal arrives
+    struct sigaction action {};
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int d = 0; d < server.pool->getNumThreads(); d++) {
+        std::thread(dispatch, std::ref(server)).detach();
+    }
+    std::cout << "listening on " << socketPath << std::endl;
+    while (!stopRequested) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd == -1) { continue; }
+        std::thread(serveConnection, std::ref(server),
+                    std::make_shared<Connection>(fd)).detach();
+    }
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    printStats(server);
+    // connection, writer and dispatcher threads still use server
+    std::_Exit(0);
+}
@@ -0,0 +1,261 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "queryprotocol.h"
+
+/**
+ * Load generator for graphserver: measures queries per second and
+ * latency percentiles from the client side
+ *
+ *     loadgen socketPath [connections] [seconds] [inFlight]
+ *
+ * Each connection keeps inFlight requests outstanding (pipelining), a
+ * mix of shortest paths, edge weights and short traversals between
+ * vertices picked at random from the server's labels. At the end it
+ * prints throughput, client-side percentiles and the server's own
+ * latency histograms
+ *
+ * Needs no library files:
+ *     g++ -std=c++17 -O2 -pthread server/loadgen.cpp -o loadgen
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using namespace queryprotocol;
+
+/** labels asked for to pick queries from */
+constexpr uint32_t kSampleLabels = 100000;
+
+/** vertices a traversal query visits at most */
+constexpr uint32_t kTraversalLimit = 64;
+
+/** open a connection to the server, -1 on error */
+int connectTo(const std::string& socketPath) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) { return -1; }
+    std::strcpy(address.sun_path, socketPath.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd != -1 && ::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                              sizeof(address)) == -1) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** send a request and wait for its answer */
+bool ask(int fd, Writer& writer, std::vector<uint8_t>& answer) {
+    return writeAll(fd, writer.finish()) && readFrame(fd, answer);
+}
+
+/** a random request with the given ID */
+Writer randomRequest(uint32_t id, const std::vector<std::string>& labels,
+                     std::mt19937& random) {
+    Writer writer;
+    writer.putU32(id);
+    auto pick = [&]() -> const std::string& {
+        return labels[random() % labels.size()];
+    };
+    int kind = static_cast<int>(random() % 10);
+    if (kind < 7) {
+        writer.putU8(kShortestPath);
+        writer.putString(pick());
+        writer.putString(pick());
+    } else if (kind < 9) {
+        writer.putU8(kEdgeWeight);
+        writer.putString(pick());
+        writer.putString(pick());
+    } else {
+        writer.putU8(random() % 2 == 0 ? kBfs : kDfs);
+        writer.putString(pick());
+        writer.putU32(kTraversalLimit);
+    }
+    return writer;
+}
+
+/** what one connection measured */
+struct ConnectionResult {
+    std::vector<uint64_t> micros;
+    uint64_t errors {0};
+};
+
+/** keep inFlight requests outstanding on one connection until deadline */
+void runConnection(const std::string& socketPath,
+                   const std::vector<std::string>& labels, int inFlight,
+                   Clock::time_point deadline, unsigned seed,
+                   ConnectionResult& result) {
+    int fd = connectTo(socketPath);
+    if (fd == -1) {
+        result.errors++;
+        return;
+    }
+    std::mt19937 random(seed);
+    std::unordered_map<uint32_t, Clock::time_point> sent;
+    std::mutex sentLock;
+    std::condition_variable answered;
+    uint32_t nextId = 0;
+    // the answers are read on a second thread, so sending never waits
+    // for them and a full pipeline is kept
+    std::thread reader([&]() {
+        std::vector<uint8_t> frame;
+        while (readFrame(fd, frame)) {
+            Reader answer(frame);
+            uint32_t id = answer.getU32();
+            uint8_t status = answer.getU8();
+            std::lock_guard<std::mutex> lock(sentLock);
+            auto it = sent.find(id);
+            if (it == sent.end()) { continue; }
+            result.micros.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - it->second).count()));
+            if (status == kBadRequest) { result.errors++; }
+            sent.erase(it);
+            answered.notify_one();
+        }
+    });
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sentLock);
+            bool room = answered.wait_until(lock, deadline, [&]() {
+                return sent.size() < static_cast<size_t>(inFlight);
+            });
+            if (!room) { break; }
+            sent[nextId] = Clock::now();
+        }
+        Writer writer = randomRequest(nextId++, labels, random);
+        if (!writeAll(fd, writer.finish())) { break; }
+    }
+    // wait for the answers still on their way, then hang up
+    {
+        std::unique_lock<std::mutex> lock(sentLock);
+        answered.wait_until(lock, deadline + std::chrono::seconds(10),
+                            [&]() { return sent.empty(); });
+    }
+    ::shutdown(fd, SHUT_RDWR);
+    reader.join();
+    ::close(fd);
+}
+
+/** microseconds at the given fraction of sorted */
+uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) { return 0; }
+    size_t i = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[i];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " socketPath [connections] [seconds] [inFlight]"
+                  << std::endl;
+        return 2;
+    }
+    std::string socketPath = argv[1];
+    int connections = argc > 2 ? std::max(1, std::atoi(argv[2])) : 4;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 5.0;
+    int inFlight = argc > 4 ? std::max(1, std::atoi(argv[4])) : 16;
+
+    int control = connectTo(socketPath);
+    if (control == -1) {
+        std::cerr << "cannot connect to " << socketPath << std::endl;
+        return 1;
+    }
+    Writer labelRequest;
+    labelRequest.putU32(0);
+    labelRequest.putU8(kLabels);
+    labelRequest.putU32(kSampleLabels);
+    std::vector<uint8_t> frame;
+    if (!ask(control, labelRequest, frame)) {
+        std::cerr << "no answer from " << socketPath << std::endl;
+        return 1;
+    }
+    Reader labelAnswer(frame);
+    labelAnswer.getU32();
+    labelAnswer.getU8();
+    std::vector<std::string> labels(labelAnswer.getU32());
+    for (auto& label : labels) { label = labelAnswer.getString(); }
+    if (labels.empty() || !labelAnswer.ok()) {
+        std::cerr << "server has no vertices" << std::endl;
+        return 1;
+    }
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+    std::vector<ConnectionResult> results(connections);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; c++) {
+        threads.emplace_back(runConnection, std::cref(socketPath),
+                             std::cref(labels), inFlight, deadline,
+                             static_cast<unsigned>(c + 1),
+                             std::ref(results[c]));
+    }
+    for (auto& thread : threads) { thread.join(); }
+    double elapsed =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<uint64_t> micros;
+    uint64_t errors = 0;
+    for (const auto& result : results) {
+        micros.insert(micros.end(), result.micros.begin(),
+                      result.micros.end());
+        errors += result.errors;
+    }
+    std::sort(micros.begin(), micros.end());
+    std::cout << micros.size() << " queries in " << elapsed << " s, "
+              << static_cast<uint64_t>(micros.size() / elapsed) << " QPS"
+              << std::endl;
+    std::cout << "latency us: p50 " << percentile(micros, 0.50) << ", p99 "
+              << percentile(micros, 0.99) << ", max "
+              << (micros.empty() ? 0 : micros.back()) << std::endl;
+    std::cout << "errors: " << errors << std::endl;
+
+    Writer statsRequest;
+    statsRequest.putU32(0);
+    statsRequest.putU8(kStats);
+    if (ask(control, statsRequest, frame)) {
+        const char* names[] = {"", "bfs", "dfs", "shortest-path",
+                               "edge-weight", "labels"};
+        Reader stats(frame);
+        stats.getU32();
+        stats.getU8();
+        std::cout << "server side:" << std::endl;
+        for (int type = kBfs; type <= kNumTimedTypes; type++) {
+            LatencyHistogram histogram;
+            histogram.count = stats.getU64();
+            for (int b = 0; b < kBuckets; b++) {
+                histogram.buckets[b] = stats.getU64();
+            }
+            std::cout << "  " << names[type] << ": " << histogram.count
+                      << " requests, p50 < " << histogram.percentile(0.50)
+                      << " us, p99 < " << histogram.percentile(0.99)
+                      << " us" << std::endl;
+        }
+    }
+    ::close(control);
+    return errors == 0 ? 0 : 1;
+}
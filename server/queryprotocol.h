@@ -0,0 +1,248 @@
+/**
+ * Binary protocol between graphserver and its clients over a Unix
+ * domain socket. Integers are little-endian, strings are a uint16 length
+ * and that many bytes
+ *
+ * Every message is a frame: uint32 length of the rest of the frame, then
+ *     request:  uint32 request ID, uint8 RequestType, payload
+ *     response: uint32 request ID, uint8 Status, payload
+ * The request ID is chosen by the client and sent back with the answer.
+ * Clients may send many requests without waiting (pipelining); answers
+ * can come back in any order
+ *
+ * Request payloads and the answers to them:
+ *     Bfs, Dfs       start, uint32 limit (0 for no limit)
+ *                    -> uint32 count, labels in visiting order
+ *     ShortestPath   start, end
+ *                    -> int64 cost (-1 if end cannot be reached),
+ *                       uint32 count, labels of the path from start to end
+ *     EdgeWeight     start, end -> int32 weight (INT_MAX if no edge)
+ *     Labels         uint32 limit -> uint32 count, labels in ID order
+ *     Stats          (none) -> for each RequestType from Bfs to Labels:
+ *                       uint64 count, kBuckets uint64 bucket counts
+ */
+
+#ifndef QUERYPROTOCOL_H
+#define QUERYPROTOCOL_H
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace queryprotocol {
+
+/** kinds of request */
+enum RequestType : uint8_t {
+    kBfs = 1,
+    kDfs,
+    kShortestPath,
+    kEdgeWeight,
+    kLabels,
+    kStats
+};
+
+/** number of request types with a latency histogram, Bfs to Labels */
+constexpr int kNumTimedTypes = kLabels;
+
+/** result of a request */
+enum Status : uint8_t {
+    kOk = 0,
+    /** a label in the request does not exist */
+    kNotFound,
+    /** the request could not be read */
+    kBadRequest
+};
+
+/** largest frame either side accepts */
+constexpr uint32_t kMaxFrame = 64u << 20;
+
+/** latency histogram buckets: bucket b counts latencies of less than
+    2^b microseconds that are not in a lower bucket */
+constexpr int kBuckets = 32;
+
+/** appends values to a frame being built */
+class Writer {
+ public:
+    /** start a frame with room for its length */
+    Writer() : bytes(4, 0) {}
+
+    /** append an unsigned integer of Bytes bytes */
+    template <int Bytes>
+    void putUnsigned(uint64_t value) {
+        for (int b = 0; b < Bytes; b++) {
+            bytes.push_back(static_cast<uint8_t>(value >> (8 * b)));
+        }
+    }
+
+    void putU8(uint8_t value) { putUnsigned<1>(value); }
+    void putU32(uint32_t value) { putUnsigned<4>(value); }
+    void putU64(uint64_t value) { putUnsigned<8>(value); }
+    void putI32(int32_t value) {
+        putUnsigned<4>(static_cast<uint32_t>(value));
+    }
+    void putI64(int64_t value) {
+        putUnsigned<8>(static_cast<uint64_t>(value));
+    }
+
+    /** append a uint16 length and the bytes of s, cut at 65535 bytes */
+    void putString(const std::string& s) {
+        size_t length = s.size() < 0xFFFF ? s.size() : 0xFFFF;
+        putUnsigned<2>(length);
+        bytes.insert(bytes.end(), s.begin(), s.begin() + length);
+    }
+
+    /** fill in the length and return the whole frame */
+    const std::vector<uint8_t>& finish() {
+        uint32_t length = static_cast<uint32_t>(bytes.size() - 4);
+        for (int b = 0; b < 4; b++) {
+            bytes[b] = static_cast<uint8_t>(length >> (8 * b));
+        }
+        return bytes;
+    }
+
+ private:
+    std::vector<uint8_t> bytes;
+};  // end Writer
+
+/** reads values from a received frame, without its length
+    reading past the end sets failed and returns zeros */
+class Reader {
+ public:
+    explicit Reader(const std::vector<uint8_t>& frame)
+        : data(frame.data()), size(frame.size()) {}
+
+    /** read an unsigned integer of Bytes bytes */
+    template <int Bytes>
+    uint64_t getUnsigned() {
+        if (size - position < static_cast<size_t>(Bytes) || failed) {
+            failed = true;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int b = 0; b < Bytes; b++) {
+            value |= static_cast<uint64_t>(data[position++]) << (8 * b);
+        }
+        return value;
+    }
+
+    uint8_t getU8() { return static_cast<uint8_t>(getUnsigned<1>()); }
+    uint32_t getU32() { return static_cast<uint32_t>(getUnsigned<4>()); }
+    uint64_t getU64() { return getUnsigned<8>(); }
+    int32_t getI32() { return static_cast<int32_t>(getUnsigned<4>()); }
+    int64_t getI64() { return static_cast<int64_t>(getUnsigned<8>()); }
+
+    /** read a uint16 length and that many bytes */
+    std::string getString() {
+        size_t length = getUnsigned<2>();
+        if (size - position < length || failed) {
+            failed = true;
+            return "";
+        }
+        std::string s(reinterpret_cast<const char*>(data) + position, length);
+        position += length;
+        return s;
+    }
+
+    /** return true if every value so far was there */
+    bool ok() const { return !failed; }
+
+    /** return true if every byte has been read */
+    bool atEnd() const { return position == size; }
+
+ private:
+    const uint8_t* data;
+    size_t size;
+    size_t position {0};
+    bool failed {false};
+};  // end Reader
+
+/** write all of bytes to fd, returns false if the other side is gone */
+inline bool writeAll(int fd, const std::vector<uint8_t>& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t sent = ::send(fd, bytes.data() + done, bytes.size() - done,
+                              MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) { continue; }
+        if (sent <= 0) { return false; }
+        done += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/** read exactly count bytes from fd into out */
+inline bool readAll(int fd, uint8_t* out, size_t count) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t got = ::read(fd, out + done, count - done);
+        if (got < 0 && errno == EINTR) { continue; }
+        if (got <= 0) { return false; }
+        done += static_cast<size_t>(got);
+    }
+    return true;
+}
+
+/** read one frame from fd into frame, without its length
+    returns false at end of stream, on error or for a frame too big */
+inline bool readFrame(int fd, std::vector<uint8_t>& frame) {
+    uint8_t header[4];
+    if (!readAll(fd, header, 4)) { return false; }
+    uint32_t length = 0;
+    for (int b = 0; b < 4; b++) {
+        length |= static_cast<uint32_t>(header[b]) << (8 * b);
+    }
+    if (length > kMaxFrame) { return false; }
+    frame.resize(length);
+    return readAll(fd, frame.data(), length);
+}
+
+/** bucket of a latency in microseconds */
+inline int bucketOf(uint64_t micros) {
+    int bucket = 0;
+    while (micros > 0 && bucket < kBuckets - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/** upper end of bucket in microseconds */
+inline uint64_t bucketLimit(int bucket) {
+    return uint64_t {1} << bucket;
+}
+
+/** counts of latencies in power of two buckets, safe to add to from
+    several threads */
+struct LatencyHistogram {
+    std::atomic<uint64_t> count {0};
+    std::atomic<uint64_t> buckets[kBuckets] = {};
+
+    /** count one latency */
+    void add(uint64_t micros) {
+        buckets[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** return the upper end of the bucket holding the given fraction of
+        latencies, 0 if there are none */
+    uint64_t percentile(double fraction) const {
+        uint64_t total = count.load(std::memory_order_relaxed);
+        if (total == 0) { return 0; }
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; b++) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (static_cast<double>(seen) >= fraction * total) {
+                return bucketLimit(b);
+            }
+        }
+        return bucketLimit(kBuckets - 1);
+    }
+};
+
+}  // namespace queryprotocol
+
+#endif  // QUERYPROTOCOL_H
@@ -0,0 +1,602 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "shardedgraph.h"
+#include "shortestpath.h"
+
+/**
+ * A graph split into shards, each served by its own worker process
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+extern char** environ;
+
+namespace {
+
+/** environment variable holding a worker's socket, set only for workers */
+const char kWorkerSocket[] = "SHARDEDGRAPH_WORKER_SOCKET";
+
+/** commands sent from the coordinator to the workers */
+enum Command : long long {
+    /** clear visited marks and costs */
+    kReset,
+    /** payload (vertex, parent place, neighbor place) triples
+        mark the unvisited ones, reply with the triples that were new */
+    kBfsClaim,
+    /** payload (vertex, place in level) pairs
+        reply, per shard, with a kBfsClaim triple for each neighbor */
+    kBfsExpand,
+    /** payload (vertex, cost, from) triples, keep the cheaper cost and
+        the vertex it came from
+        reply, per shard, with (neighbor, cost, vertex) for each vertex
+        whose cost went down */
+    kSsspRelax,
+    /** reply, per shard, with (neighbor, cost, vertex) for each edge out
+        of a reached vertex */
+    kSsspOffer,
+    /** payload kSsspOffer triples, reply with two lists: (vertex, cost,
+        last vertex that lowered it) for each reached vertex, and
+        (vertex, neighbor) for each offer that matches the neighbor's
+        cost, an edge on a cheapest path */
+    kSsspTight,
+    /** exit the worker */
+    kQuit
+};
+
+/** what a worker knows about its shard */
+struct Shard {
+    /** number of shards */
+    int numShards {0};
+
+    /** vertex ID to index in this shard, for vertices it owns */
+    std::unordered_map<int, int> local;
+
+    /** vertex IDs of owned vertices */
+    std::vector<int> owned;
+
+    /** adjacency of owned vertices in Graph order, targets are vertex IDs */
+    std::vector<long long> offsets;
+    std::vector<int> targets;
+    std::vector<int> weights;
+
+    /** shard of every vertex that is a target here */
+    std::unordered_map<int, int> shardOf;
+};
+
+/** write all of message to fd, prefixed with its length
+    a worker that is gone is an error, not a SIGPIPE */
+void writeMessage(int fd, const std::vector<long long>& message) {
+    long long size = static_cast<long long>(message.size());
+    const char* parts[2] = {reinterpret_cast<const char*>(&size),
+                            reinterpret_cast<const char*>(message.data())};
+    size_t lengths[2] = {sizeof(size), message.size() * sizeof(long long)};
+    for (int p = 0; p < 2; p++) {
+        size_t done = 0;
+        while (done < lengths[p]) {
+            ssize_t n = send(fd, parts[p] + done, lengths[p] - done,
+                             MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) {
+                throw std::runtime_error("shard socket write failed");
+            }
+            done += n;
+        }
+    }
+}
+
+/** read exactly length bytes, false on end of file */
+bool readExactly(int fd, char* buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = read(fd, buffer + done, length - done);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        done += n;
+    }
+    return true;
+}
+
+/** read one length-prefixed message */
+std::vector<long long> readMessage(int fd) {
+    long long size = 0;
+    if (!readExactly(fd, reinterpret_cast<char*>(&size), sizeof(size))) {
+        throw std::runtime_error("shard socket closed");
+    }
+    std::vector<long long> message(size);
+    if (!readExactly(fd, reinterpret_cast<char*>(message.data()),
+                     size * sizeof(long long))) {
+        throw std::runtime_error("shard socket closed");
+    }
+    return message;
+}
+
+/** flatten one list per shard into [size, list..., size, list...] */
+std::vector<long long> flatten(const std::vector<std::vector<long long>>& l) {
+    std::vector<long long> flat;
+    for (const auto& list : l) {
+        flat.push_back(static_cast<long long>(list.size()));
+        flat.insert(flat.end(), list.begin(), list.end());
+    }
+    return flat;
+}
+
+/** route per-shard lists from every reply to the shard they are for */
+std::vector<std::vector<long long>> route(
+    const std::vector<std::vector<long long>>& replies, int numShards) {
+    std::vector<std::vector<long long>> routed(numShards);
+    for (const auto& reply : replies) {
+        size_t pos = 0;
+        for (int s = 0; s < numShards; s++) {
+            size_t size = reply[pos++];
+            routed[s].insert(routed[s].end(), reply.begin() + pos,
+                             reply.begin() + pos + size);
+            pos += size;
+        }
+    }
+    return routed;
+}
+
+/** shard as one message, see readShard */
+std::vector<long long> writeShard(const Shard& shard) {
+    std::vector<long long> message {shard.numShards,
+                                    static_cast<long long>(shard.owned.size()),
+                                    static_cast<long long>(
+                                        shard.targets.size())};
+    message.insert(message.end(), shard.owned.begin(), shard.owned.end());
+    message.insert(message.end(), shard.offsets.begin(), shard.offsets.end());
+    message.insert(message.end(), shard.targets.begin(), shard.targets.end());
+    message.insert(message.end(), shard.weights.begin(), shard.weights.end());
+    for (const auto& [vertex, shardOfVertex] : shard.shardOf) {
+        message.push_back(vertex);
+        message.push_back(shardOfVertex);
+    }
+    return message;
+}
+
+/** shard from a message written by writeShard */
+Shard readShard(const std::vector<long long>& message) {
+    Shard shard;
+    shard.numShards = static_cast<int>(message.at(0));
+    size_t n = static_cast<size_t>(message.at(1));
+    size_t m = static_cast<size_t>(message.at(2));
+    size_t pos = 3;
+    if (message.size() < pos + n + (n + 1) + 2 * m) {
+        throw std::runtime_error("short shard message");
+    }
+    shard.owned.assign(message.begin() + pos, message.begin() + pos + n);
+    pos += n;
+    shard.offsets.assign(message.begin() + pos,
+                         message.begin() + pos + n + 1);
+    pos += n + 1;
+    shard.targets.assign(message.begin() + pos, message.begin() + pos + m);
+    pos += m;
+    shard.weights.assign(message.begin() + pos, message.begin() + pos + m);
+    pos += m;
+    for (; pos + 1 < message.size(); pos += 2) {
+        shard.shardOf[static_cast<int>(message[pos])] =
+            static_cast<int>(message[pos + 1]);
+    }
+    for (size_t v = 0; v < n; v++) {
+        shard.local[shard.owned[v]] = static_cast<int>(v);
+    }
+    return shard;
+}
+
+/** serve commands from the coordinator on socket until kQuit */
+void workerLoop(const Shard& shard, int socket) {
+    int n = static_cast<int>(shard.owned.size());
+    std::vector<char> visited(n, 0);
+    std::vector<long long> cost(n, LLONG_MAX);
+    std::vector<int> lowered(n, -1);
+    while (true) {
+        std::vector<long long> message = readMessage(socket);
+        long long command = message[0];
+        std::vector<long long> reply;
+        std::vector<std::vector<long long>> perShard(shard.numShards);
+        if (command == kQuit) { return; }
+        if (command == kReset) {
+            std::fill(visited.begin(), visited.end(), 0);
+            std::fill(cost.begin(), cost.end(), LLONG_MAX);
+            std::fill(lowered.begin(), lowered.end(), -1);
+        } else if (command == kBfsClaim) {
+            // lowest (parent place, neighbor place) wins each vertex
+            std::unordered_map<int, std::pair<long long, long long>> best;
+            std::vector<int> order;
+            for (size_t i = 1; i + 2 < message.size(); i += 3) {
+                int v = shard.local.at(static_cast<int>(message[i]));
+                if (visited[v] != 0) { continue; }
+                std::pair<long long, long long> key {message[i + 1],
+                                                     message[i + 2]};
+                auto [it, inserted] = best.emplace(v, key);
+                if (inserted) {
+                    order.push_back(v);
+                } else if (key < it->second) {
+                    it->second = key;
+                }
+            }
+            for (int v : order) {
+                visited[v] = 1;
+                reply.push_back(shard.owned[v]);
+                reply.push_back(best[v].first);
+                reply.push_back(best[v].second);
+            }
+        } else if (command == kBfsExpand) {
+            for (size_t i = 1; i + 1 < message.size(); i += 2) {
+                int v = shard.local.at(static_cast<int>(message[i]));
+                for (long long e = shard.offsets[v]; e < shard.offsets[v + 1];
+                     e++) {
+                    auto& list = perShard[shard.shardOf.at(shard.targets[e])];
+                    list.push_back(shard.targets[e]);
+                    list.push_back(message[i + 1]);
+                    list.push_back(e - shard.offsets[v]);
+                }
+            }
+            reply = flatten(perShard);
+        } else if (command == kSsspRelax) {
+            // visited marks vertices already in improved
+            std::vector<int> improved;
+            for (size_t i = 1; i + 2 < message.size(); i += 3) {
+                int v = shard.local.at(static_cast<int>(message[i]));
+                if (message[i + 1] < cost[v]) {
+                    if (visited[v] == 0) { improved.push_back(v); }
+                    visited[v] = 1;
+                    cost[v] = message[i + 1];
+                    lowered[v] = static_cast<int>(message[i + 2]);
+                }
+            }
+            // only send the cheapest offer to each neighbor
+            std::unordered_map<int, std::pair<long long, int>> offers;
+            std::vector<int> offerOrder;
+            for (int v : improved) {
+                visited[v] = 0;
+                for (long long e = shard.offsets[v]; e < shard.offsets[v + 1];
+                     e++) {
+                    std::pair<long long, int> offer {
+                        cost[v] + shard.weights[e], shard.owned[v]};
+                    auto [it, inserted] = offers.emplace(shard.targets[e],
+                                                         offer);
+                    if (inserted) {
+                        offerOrder.push_back(shard.targets[e]);
+                    } else if (offer.first < it->second.first) {
+                        it->second = offer;
+                    }
+                }
+            }
+            for (int u : offerOrder) {
+                auto& list = perShard[shard.shardOf.at(u)];
+                list.push_back(u);
+                list.push_back(offers[u].first);
+                list.push_back(offers[u].second);
+            }
+            reply = flatten(perShard);
+        } else if (command == kSsspOffer) {
+            for (int v = 0; v < n; v++) {
+                if (cost[v] == LLONG_MAX) { continue; }
+                for (long long e = shard.offsets[v]; e < shard.offsets[v + 1];
+                     e++) {
+                    auto& list = perShard[shard.shardOf.at(shard.targets[e])];
+                    list.push_back(shard.targets[e]);
+                    list.push_back(cost[v] + shard.weights[e]);
+                    list.push_back(shard.owned[v]);
+                }
+            }
+            reply = flatten(perShard);
+        } else if (command == kSsspTight) {
+            std::vector<std::vector<long long>> lists(2);
+            for (int u = 0; u < n; u++) {
+                if (cost[u] == LLONG_MAX) { continue; }
+                lists[0].push_back(shard.owned[u]);
+                lists[0].push_back(cost[u]);
+                lists[0].push_back(lowered[u]);
+            }
+            for (size_t i = 1; i + 2 < message.size(); i += 3) {
+                int u = shard.local.at(static_cast<int>(message[i]));
+                if (message[i + 1] == cost[u]) {
+                    lists[1].push_back(message[i + 2]);
+                    lists[1].push_back(shard.owned[u]);
+                }
+            }
+            reply = flatten(lists);
+        }
+        writeMessage(socket, reply);
+    }
+}
+
+/** close every file descriptor but the standard ones and keep, which
+    a worker inherits from whatever the coordinator had open */
+void closeInherited(int keep) {
+    DIR* dir = opendir("/proc/self/fd");
+    if (dir == nullptr) { return; }
+    std::vector<int> open;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+            open.push_back(std::atoi(entry->d_name));
+        }
+    }
+    int listing = dirfd(dir);
+    for (int fd : open) {
+        if (fd > 2 && fd != keep && fd != listing) { close(fd); }
+    }
+    closedir(dir);
+}
+
+}  // namespace
+
+/** if this process was started as a shard worker, serve the coordinator
+    and exit, otherwise return at once */
+void ShardedGraph::runWorkerIfRequested() {
+    const char* socketName = std::getenv(kWorkerSocket);
+    if (socketName == nullptr) { return; }
+    int socket = std::atoi(socketName);
+    // programs the worker might start are not workers themselves
+    unsetenv(kWorkerSocket);
+    closeInherited(socket);
+    int status = 0;
+    try {
+        workerLoop(readShard(readMessage(socket)), socket);
+    } catch (const std::exception&) {
+        status = 1;
+    }
+    _exit(status);
+}
+
+/** partition graph into numShards shards and start one worker process
+    for each */
+ShardedGraph::ShardedGraph(const Graph& graph, int numShards) {
+    partition = partitionGraph(graph, numShards);
+    int n = graph.getNumVertices();
+    for (int v = 0; v < n; v++) {
+        labels.push_back(graph.getLabel(v));
+        index.insert(labels.back(), v);
+    }
+    std::vector<int> byLabel(n);
+    for (int v = 0; v < n; v++) { byLabel[v] = v; }
+    std::sort(byLabel.begin(), byLabel.end(), [this](int a, int b) {
+        return labels[a] < labels[b];
+    });
+    labelRank.resize(n);
+    for (int r = 0; r < n; r++) { labelRank[byLabel[r]] = r; }
+    try {
+        for (int s = 0; s < partition.numShards; s++) {
+            Shard shard;
+            shard.numShards = partition.numShards;
+            shard.offsets.push_back(0);
+            for (int v = 0; v < n; v++) {
+                if (partition.shardOf[v] != s) { continue; }
+                shard.owned.push_back(v);
+                graph.forEachNeighbor(v, [&](int u, int edgeWeight) {
+                    shard.targets.push_back(u);
+                    shard.weights.push_back(edgeWeight);
+                    shard.shardOf[u] = partition.shardOf[u];
+                    negativeWeights |= edgeWeight < 0;
+                    return true;
+                });
+                shard.offsets.push_back(
+                    static_cast<long long>(shard.targets.size()));
+            }
+            startWorker();
+            writeMessage(workers.back().socket, writeShard(shard));
+        }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+}
+
+/** stop the workers and wait for them to exit */
+ShardedGraph::~ShardedGraph() {
+    stopWorkers();
+}
+
+/** return the shard each vertex is in */
+const Partition& ShardedGraph::getPartition() const {
+    return partition;
+}
+
+/** return number of vertices */
+int ShardedGraph::getNumVertices() const {
+    return static_cast<int>(labels.size());
+}
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int ShardedGraph::findId(const std::string& vertexLabel) const {
+    const int* id = index.find(vertexLabel);
+    return id == nullptr ? -1 : *id;
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& ShardedGraph::getLabel(int id) const {
+    return labels[id];
+}
+
+/** find the lowest cost from startLabel to all vertices that can be
+    reached, output as in Graph::djikstraCostToAllVertices */
+bool ShardedGraph::djikstraCostToAllVertices(
+    const std::string& startLabel,
+    std::map<std::string, int>& weight,
+    std::map<std::string, std::string>& previous) const {
+    weight.clear();
+    previous.clear();
+    int startId = findId(startLabel);
+    if (startId == -1) { return true; }
+    int n = getNumVertices();
+    int numShards = partition.numShards;
+    std::vector<std::vector<long long>> none(numShards);
+    exchange(kReset, none);
+    // relax until no cost changes anywhere; without a negative cycle
+    // every cheapest path has fewer than n edges and is found by then
+    std::vector<std::vector<long long>> updates(numShards);
+    updates[partition.shardOf[startId]] = {startId, 0, -1};
+    for (int round = 0;; round++) {
+        updates = route(exchange(kSsspRelax, updates), numShards);
+        bool changed = false;
+        for (const auto& list : updates) { changed |= !list.empty(); }
+        if (!changed) { break; }
+        if (round >= n) { return false; }
+    }
+    auto offers = route(exchange(kSsspOffer, none), numShards);
+    std::vector<long long> cost(n, shortestpath::kUnreachable);
+    std::vector<int> previousId(n, -1);
+    std::vector<shortestpath::detail::TightEdge> tight;
+    // offers to the start close cycles back to it, keep the cheapest
+    long long cycleCost = shortestpath::kUnreachable;
+    int cycleFrom = -1;
+    const auto& toStart = offers[partition.shardOf[startId]];
+    for (size_t i = 0; i + 2 < toStart.size(); i += 3) {
+        if (toStart[i] == startId && toStart[i + 1] < cycleCost) {
+            cycleCost = toStart[i + 1];
+            cycleFrom = static_cast<int>(toStart[i + 2]);
+        }
+    }
+    for (size_t i = 0; i + 2 < toStart.size(); i += 3) {
+        if (toStart[i] == startId && toStart[i + 1] == cycleCost) {
+            tight.push_back({static_cast<int>(toStart[i + 2]), startId});
+        }
+    }
+    for (const auto& reply : exchange(kSsspTight, offers)) {
+        size_t numReached = reply[0];
+        for (size_t i = 1; i + 2 <= numReached; i += 3) {
+            cost[reply[i]] = reply[i + 1];
+            previousId[reply[i]] = static_cast<int>(reply[i + 2]);
+        }
+        for (size_t i = numReached + 2; i + 1 < reply.size(); i += 2) {
+            tight.push_back({static_cast<int>(reply[i]),
+                             static_cast<int>(reply[i + 1])});
+        }
+    }
+    // with negative weights Dijkstra has no settle order to match, keep
+    // the vertex that last lowered each cost as Bellman-Ford does
+    if (!negativeWeights) {
+        shortestpath::detail::previousFromTightEdges(
+            startId, cost, tight,
+            [this](int a, int b) { return labelRank[a] > labelRank[b]; },
+            previousId);
+    } else if (cycleCost != shortestpath::kUnreachable) {
+        previousId[startId] = cycleFrom;
+    }
+    cost[startId] = cycleCost;
+    for (int v = 0; v < n; v++) {
+        // left out like an unreachable vertex if it does not fit an int
+        if (cost[v] < INT_MIN || cost[v] > INT_MAX) { continue; }
+        weight[labels[v]] = static_cast<int>(cost[v]);
+        previous[labels[v]] = labels[previousId[v]];
+    }
+    return true;
+}
+
+/** send command with payload[s] to worker s, return every reply */
+std::vector<std::vector<long long>> ShardedGraph::exchange(
+    long long command,
+    const std::vector<std::vector<long long>>& payload) const {
+    // send everything first so the workers run at the same time
+    for (size_t s = 0; s < workers.size(); s++) {
+        std::vector<long long> message {command};
+        message.insert(message.end(), payload[s].begin(), payload[s].end());
+        writeMessage(workers[s].socket, message);
+    }
+    std::vector<std::vector<long long>> replies;
+    for (const Worker& worker : workers) {
+        replies.push_back(readMessage(worker.socket));
+    }
+    return replies;
+}
+
+/** start one more worker process, see runWorkerIfRequested */
+void ShardedGraph::startWorker() {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::runtime_error("could not create shard socket");
+    }
+    // later workers must not inherit this one's end
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+    // a fresh run of this program rather than a fork: a fork copies a
+    // process that may have other threads holding locks, exec does not
+    std::vector<std::string> variables;
+    for (char** variable = environ; *variable != nullptr; variable++) {
+        variables.push_back(*variable);
+    }
+    variables.push_back(std::string(kWorkerSocket) + "=" +
+                        std::to_string(sockets[1]));
+    std::vector<char*> envp;
+    for (auto& variable : variables) { envp.push_back(variable.data()); }
+    envp.push_back(nullptr);
+    char name[] = "shardworker";
+    char* argv[] = {name, nullptr};
+    pid_t pid = -1;
+    int failed = posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, argv,
+                             envp.data());
+    close(sockets[1]);
+    if (failed != 0) {
+        close(sockets[0]);
+        throw std::runtime_error("could not start shard worker");
+    }
+    workers.push_back({pid, sockets[0]});
+}
+
+/** tell every worker to quit and wait for it */
+void ShardedGraph::stopWorkers() {
+    for (const Worker& worker : workers) {
+        try {
+            writeMessage(worker.socket, {kQuit});
+        } catch (const std::exception&) {
+            // already gone
+        }
+        close(worker.socket);
+    }
+    for (const Worker& worker : workers) {
+        waitpid(worker.pid, nullptr, 0);
+    }
+    workers.clear();
+}
+
+/** clear visited marks and mark startId, the first BFS level */
+void ShardedGraph::bfsStart(int startId) const {
+    std::vector<std::vector<long long>> payload(partition.numShards);
+    exchange(kReset, payload);
+    payload[partition.shardOf[startId]] = {startId, -1, 0};
+    exchange(kBfsClaim, payload);
+}
+
+/** next BFS level after frontier, in visiting order */
+std::vector<int> ShardedGraph::bfsExpand(
+    const std::vector<int>& frontier) const {
+    std::vector<int> level;
+    if (frontier.empty()) { return level; }
+    int numShards = partition.numShards;
+    std::vector<std::vector<long long>> payload(numShards);
+    for (size_t place = 0; place < frontier.size(); place++) {
+        auto& list = payload[partition.shardOf[frontier[place]]];
+        list.push_back(frontier[place]);
+        list.push_back(static_cast<long long>(place));
+    }
+    auto claims = route(exchange(kBfsExpand, payload), numShards);
+    std::vector<std::tuple<long long, long long, int>> found;
+    for (const auto& reply : exchange(kBfsClaim, claims)) {
+        for (size_t i = 0; i + 2 < reply.size(); i += 3) {
+            found.emplace_back(reply[i + 1], reply[i + 2],
+                               static_cast<int>(reply[i]));
+        }
+    }
+    // Graph visits by parent's place, then by place among its neighbors
+    std::sort(found.begin(), found.end());
+    for (const auto& entry : found) { level.push_back(std::get<2>(entry)); }
+    return level;
+}
@@ -0,0 +1,149 @@
+/**
+ * A graph split into shards, each served by its own worker process
+ * The coordinator (the process that built the ShardedGraph) keeps only
+ * labels and the partition. Each worker owns the adjacency lists of the
+ * vertices in its shard and knows which shard every neighbor (ghost)
+ * lives in. Workers are new runs of the same program, started with
+ * posix_spawn rather than fork so no lock held by another thread is
+ * copied into them, and talk to the coordinator over a Unix socket.
+ * A program that uses ShardedGraph must call runWorkerIfRequested first
+ * thing in main; in a worker it serves the coordinator and never returns
+ * Frontier updates for other shards are routed through the coordinator
+ *
+ * Breadth-first traversal is level synchronous. Every new vertex is
+ * tagged with its parent's place in the current level and its place in
+ * the parent's neighbor list, and sorting a level by that tag gives the
+ * same order as Graph::breadthFirstTraversal
+ * Shortest paths run rounds of edge relaxation until no cost changes.
+ * The workers then report every edge on a cheapest path, and the
+ * coordinator picks from those the predecessor Dijkstra would have
+ * settled first, so results match Graph, zero weight edges included.
+ * With negative weights there is no such order; each vertex keeps the
+ * last vertex that lowered its cost, as Bellman-Ford does
+ */
+
+#ifndef SHARDEDGRAPH_H
+#define SHARDEDGRAPH_H
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "labelhashmap.h"
+#include "partition.h"
+#include "traversal.h"
+
+class ShardedGraph {
+ public:
+    /** partition graph into numShards shards and start one worker
+        process for each; the graph can be changed or deleted afterwards
+        throws std::runtime_error if a worker cannot be started */
+    ShardedGraph(const Graph& graph, int numShards);
+
+    /** stop the workers and wait for them to exit */
+    ~ShardedGraph();
+
+    ShardedGraph(const ShardedGraph&) = delete;
+    ShardedGraph& operator=(const ShardedGraph&) = delete;
+
+    /** if this process was started as a shard worker, serve the
+        coordinator and exit, otherwise return at once
+        call at the top of main, before anything else is set up */
+    static void runWorkerIfRequested();
+
+    /** return the shard each vertex is in */
+    const Partition& getPartition() const;
+
+    /** return number of vertices */
+    int getNumVertices() const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist
+        IDs are the ones the source Graph used */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID */
+    const std::string& getLabel(int id) const;
+
+    /** breadth-first traversal starting from startLabel, visits vertices
+        in the same order as Graph::breadthFirstTraversal
+        visit can be any callable, see traversal.h */
+    template <typename Visitor>
+    void breadthFirstTraversal(const std::string& startLabel,
+                               Visitor&& visit) const;
+
+    /** find the lowest cost from startLabel to all vertices that can be
+        reached, output as in Graph::djikstraCostToAllVertices
+        returns false, with nothing in the maps, if a negative cycle can
+        be reached: relaxation then stops after getNumVertices() rounds */
+    bool djikstraCostToAllVertices(
+        const std::string& startLabel,
+        std::map<std::string, int>& weight,
+        std::map<std::string, std::string>& previous) const;
+
+ private:
+    /** a worker process and the coordinator's end of its socket */
+    struct Worker {
+        pid_t pid;
+        int socket;
+    };
+
+    /** send command with payload[s] to worker s, return every reply */
+    std::vector<std::vector<long long>> exchange(
+        long long command,
+        const std::vector<std::vector<long long>>& payload) const;
+
+    /** start one more worker process, added to workers */
+    void startWorker();
+
+    /** tell every worker to quit and wait for it */
+    void stopWorkers();
+
+    /** clear visited marks and mark startId, the first BFS level */
+    void bfsStart(int startId) const;
+
+    /** next BFS level after frontier, in visiting order */
+    std::vector<int> bfsExpand(const std::vector<int>& frontier) const;
+
+    /** shard of each vertex */
+    Partition partition;
+
+    /** vertex labels by ID */
+    std::vector<std::string> labels;
+
+    /** label to ID */
+    LabelHashMap<int> index;
+
+    /** place of each vertex in label order, Dijkstra's tie-break */
+    std::vector<int> labelRank;
+
+    /** true if any edge weight is below zero */
+    bool negativeWeights {false};
+
+    /** one worker per shard */
+    std::vector<Worker> workers;
+};  // end ShardedGraph
+
+/** breadth-first traversal starting from startLabel */
+template <typename Visitor>
+void ShardedGraph::breadthFirstTraversal(const std::string& startLabel,
+                                         Visitor&& visit) const {
+    int startId = findId(startLabel);
+    if (startId == -1) { return; }
+    bfsStart(startId);
+    std::vector<int> level {startId};
+    while (!level.empty()) {
+        std::vector<int> frontier;
+        for (int v : level) {
+            VisitAction action = traversal::detail::callVisitor(
+                visit, VertexHandle<ShardedGraph>(*this, v));
+            if (action == VisitAction::Stop) { return; }
+            if (action == VisitAction::Continue) { frontier.push_back(v); }
+        }
+        level = bfsExpand(frontier);
+    }
+}
+
+#endif  // SHARDEDGRAPH_H
@@ -0,0 +1,506 @@
+/**
+ * Shortest-path algorithms for any graph view (see traversal.h)
+ * Works on vertex IDs and keeps its state in local arrays, so it never
+ * writes to the graph and several searches can run on it at once
+ * Vertices at the same cost are settled in reverse label order and a
+ * predecessor is only replaced by a strictly cheaper one, which gives the
+ * same previous entries as Graph::djikstraCostToAllVertices
+ *
+ * dijkstraCsr and bellmanFord need a view with flat adjacency arrays,
+ * such as CsrGraph, and relax a vertex's edges with relaxkernel. In
+ * dijkstraCsr the edges of a vertex with many neighbors can also be
+ * split over a ThreadPool, which is safe because each neighbor appears
+ * once in the list
+ */
+
+#ifndef SHORTESTPATH_H
+#define SHORTESTPATH_H
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "relaxkernel.h"
+#include "threadpool.h"
+
+namespace shortestpath {
+
+/** cost of a vertex that cannot be reached */
+constexpr long long kUnreachable = LLONG_MAX;
+
+/** cost of the cheapest cycle back to startId, closed by the edge from
+    previousId[startId], kUnreachable if there is none */
+template <typename GraphView>
+long long cycleCost(const GraphView& graph, int startId,
+                    const std::vector<long long>& cost,
+                    const std::vector<int>& previousId) {
+    int last = previousId[startId];
+    long long cheapest = kUnreachable;
+    if (last == -1) { return cheapest; }
+    graph.forEachNeighbor(last, [&](int u, int edgeWeight) {
+        if (u == startId) {
+            cheapest = std::min(cheapest, cost[last] + edgeWeight);
+        }
+        return true;
+    });
+    return cheapest;
+}
+
+/** turn ID-indexed results into label-keyed maps, leaving out
+    unreachable vertices; the start vertex is listed with startCost,
+    that of the cheapest cycle back to it, unless that is kUnreachable
+    Cost is int for the maps Graph has always filled, or long long
+    vertices whose cost does not fit in Cost are left out rather than
+    listed with a wrapped cost; the long long maps have them all */
+template <typename GraphView, typename Cost>
+void toLabels(const GraphView& graph, int startId,
+              const std::vector<long long>& cost,
+              const std::vector<int>& previousId,
+              std::map<std::string, Cost>& weight,
+              std::map<std::string, std::string>& previous,
+              long long startCost = kUnreachable) {
+    weight.clear();
+    previous.clear();
+    for (int v = 0; v < graph.getNumVertices(); v++) {
+        long long c = v == startId ? startCost : cost[v];
+        if (c != kUnreachable &&
+            c >= std::numeric_limits<Cost>::min() &&
+            c <= std::numeric_limits<Cost>::max()) {
+            weight[graph.getLabel(v)] = static_cast<Cost>(c);
+            previous[graph.getLabel(v)] = graph.getLabel(previousId[v]);
+        }
+    }
+}
+
+/** find the lowest cost from startId to every vertex
+    cost[v] is kUnreachable if v cannot be reached, cost[startId] is 0
+    previous[v] is the vertex before v on the path, -1 if none
+    previous[startId] closes the cheapest cycle back to the start, the
+    first such vertex settled, -1 if no cycle leads back */
+template <typename GraphView>
+void dijkstra(const GraphView& graph, int startId,
+              std::vector<long long>& cost, std::vector<int>& previous) {
+    cost.assign(graph.getNumVertices(), kUnreachable);
+    previous.assign(graph.getNumVertices(), -1);
+    std::vector<char> settled(graph.getNumVertices(), 0);
+    // lowest cost on top, larger label first among equal costs
+    auto lowerPriority = [&graph](const std::pair<long long, int>& a,
+                                  const std::pair<long long, int>& b) {
+        if (a.first != b.first) { return a.first > b.first; }
+        return graph.getLabel(a.second) < graph.getLabel(b.second);
+    };
+    std::priority_queue<std::pair<long long, int>,
+                        std::vector<std::pair<long long, int>>,
+                        decltype(lowerPriority)> pq(lowerPriority);
+    cost[startId] = 0;
+    pq.push({0, startId});
+    long long cheapestCycle = kUnreachable;
+    while (!pq.empty()) {
+        int v = pq.top().second;
+        pq.pop();
+        if (settled[v] != 0) { continue; }
+        settled[v] = 1;
+        graph.forEachNeighbor(v, [&](int u, int edgeWeight) {
+            long long viaV = cost[v] + edgeWeight;
+            if (u == startId) {
+                if (viaV < cheapestCycle) {
+                    cheapestCycle = viaV;
+                    previous[u] = v;
+                }
+            } else if (settled[u] == 0 && viaV < cost[u]) {
+                cost[u] = viaV;
+                previous[u] = v;
+                pq.push({viaV, u});
+            }
+            return true;
+        });
+    }
+}
+
+/** scratch space of dijkstraCsr, kept between searches so a later one
+    allocates nothing the graph has not outgrown */
+struct DijkstraWorkspace {
+    /** settled marks by vertex ID */
+    std::vector<char> settled;
+
+    /** heap of (cost, vertex) */
+    std::vector<std::pair<long long, int>> heap;
+
+    /** improving edges found in each slice of edges, and their number */
+    std::vector<std::vector<int>> improved;
+    std::vector<int> numImproved;
+};
+
+/** dijkstra over flat adjacency arrays, graph must provide getOffsets(),
+    getTargets() and getWeights() as CsrGraph does
+    edges are relaxed with relaxkernel, and with a pool the edges of
+    vertices with many neighbors are split over its workers
+    gives the same results as dijkstra */
+template <typename GraphView>
+void dijkstraCsr(const GraphView& graph, int startId,
+                 std::vector<long long>& cost, std::vector<int>& previous,
+                 DijkstraWorkspace& workspace, ThreadPool* pool = nullptr) {
+    // edges per kernel call, and per task for vertices with many neighbors
+    const long long grain = 4096;
+    const std::vector<long long>& offsets = graph.getOffsets();
+    const std::vector<int>& targets = graph.getTargets();
+    const std::vector<int>& weights = graph.getWeights();
+    cost.assign(graph.getNumVertices(), kUnreachable);
+    previous.assign(graph.getNumVertices(), -1);
+    std::vector<char>& settled = workspace.settled;
+    settled.assign(graph.getNumVertices(), 0);
+    // lowest cost on top, larger label first among equal costs
+    auto lowerPriority = [&graph](const std::pair<long long, int>& a,
+                                  const std::pair<long long, int>& b) {
+        if (a.first != b.first) { return a.first > b.first; }
+        return graph.getLabel(a.second) < graph.getLabel(b.second);
+    };
+    std::vector<std::pair<long long, int>>& heap = workspace.heap;
+    heap.clear();
+    auto push = [&](long long c, int v) {
+        heap.push_back({c, v});
+        std::push_heap(heap.begin(), heap.end(), lowerPriority);
+    };
+    std::vector<std::vector<int>>& improved = workspace.improved;
+    std::vector<int>& numImproved = workspace.numImproved;
+    auto relax = [&](int v, long long c) {
+        long long first = offsets[v] + c * grain;
+        int count = static_cast<int>(std::min(offsets[v + 1] - first, grain));
+        improved[c].resize(count);
+        numImproved[c] = relaxkernel::relaxEdges(
+            cost[v], targets.data() + first, weights.data() + first, count,
+            cost.data(), improved[c].data());
+    };
+    cost[startId] = 0;
+    push(0, startId);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), lowerPriority);
+        int v = heap.back().second;
+        heap.pop_back();
+        if (settled[v] != 0) { continue; }
+        settled[v] = 1;
+        long long degree = offsets[v + 1] - offsets[v];
+        long long numChunks = (degree + grain - 1) / grain;
+        if (improved.size() < static_cast<size_t>(numChunks)) {
+            improved.resize(numChunks);
+            numImproved.resize(numChunks);
+        }
+        if (pool == nullptr || numChunks <= 1) {
+            for (long long c = 0; c < numChunks; c++) { relax(v, c); }
+        } else {
+            // slices only read costs, so they can run side by side
+            pool->parallelFor(0, numChunks, 1, [&](long long first,
+                                                   long long last) {
+                for (long long c = first; c < last; c++) { relax(v, c); }
+            });
+        }
+        // apply in edge order, each neighbor appears once in the list
+        for (long long c = 0; c < numChunks; c++) {
+            long long first = offsets[v] + c * grain;
+            for (int k = 0; k < numImproved[c]; k++) {
+                long long i = first + improved[c][k];
+                int u = targets[i];
+                if (settled[u] != 0 && u != startId) { continue; }
+                cost[u] = cost[v] + weights[i];
+                previous[u] = v;
+                if (u != startId) { push(cost[u], u); }
+            }
+        }
+        // from here on the start's cost is that of the cheapest cycle
+        // back to it, so the kernel finds edges that lower it
+        if (v == startId) { cost[startId] = kUnreachable; }
+    }
+    cost[startId] = 0;
+}
+
+/** dijkstraCsr with scratch space of its own */
+template <typename GraphView>
+void dijkstraCsr(const GraphView& graph, int startId,
+                 std::vector<long long>& cost, std::vector<int>& previous,
+                 ThreadPool* pool = nullptr) {
+    DijkstraWorkspace workspace;
+    dijkstraCsr(graph, startId, cost, previous, workspace, pool);
+}
+
+namespace detail {
+
+/** an edge that lies on a cheapest path: cost[from] + weight == cost[to]
+    an edge into the start lies on the cheapest cycle back to it */
+struct TightEdge {
+    int from;
+    int to;
+};
+
+/** previous entries as dijkstra picks them, from the final costs and
+    every tight edge, for searches that find costs some other way
+    weights must not be negative; settlesFirst(a, b) is true if a is
+    settled before b at equal cost, the larger label in dijkstra
+    replays dijkstra's settle order: by cost, and within one cost,
+    starting from the vertices reached from cheaper ones and following
+    zero weight edges, always taking the first by settlesFirst waiting
+    then each vertex gets its tight predecessor that settled first, and
+    so does the start from the edges closing its cheapest cycle */
+template <typename SettlesFirst>
+void previousFromTightEdges(int startId, const std::vector<long long>& cost,
+                            const std::vector<TightEdge>& tight,
+                            SettlesFirst&& settlesFirst,
+                            std::vector<int>& previous) {
+    int n = static_cast<int>(cost.size());
+    previous.assign(n, -1);
+    // zero weight edges by start vertex, and the vertices entered
+    // from a cheaper one
+    std::vector<char> entered(n, 0);
+    std::vector<int> zeroOffsets(n + 1, 0);
+    for (const TightEdge& edge : tight) {
+        if (cost[edge.from] == cost[edge.to]) {
+            zeroOffsets[edge.from + 1]++;
+        } else {
+            entered[edge.to] = 1;
+        }
+    }
+    for (int v = 0; v < n; v++) { zeroOffsets[v + 1] += zeroOffsets[v]; }
+    std::vector<int> zeroTargets(zeroOffsets[n]);
+    std::vector<int> next(zeroOffsets.begin(), zeroOffsets.end() - 1);
+    for (const TightEdge& edge : tight) {
+        if (cost[edge.from] == cost[edge.to]) {
+            zeroTargets[next[edge.from]++] = edge.to;
+        }
+    }
+    entered[startId] = 1;
+    std::vector<int> reached;
+    for (int v = 0; v < n; v++) {
+        if (cost[v] != kUnreachable) { reached.push_back(v); }
+    }
+    std::sort(reached.begin(), reached.end(), [&cost](int a, int b) {
+        return cost[a] < cost[b];
+    });
+    // first to settle on top of the heap
+    auto later = [&settlesFirst](int a, int b) { return settlesFirst(b, a); };
+    std::vector<int> rank(n, -1);
+    std::vector<int> waiting;
+    int settled = 0;
+    for (size_t first = 0; first < reached.size();) {
+        size_t last = first;
+        while (last < reached.size() &&
+               cost[reached[last]] == cost[reached[first]]) {
+            last++;
+        }
+        for (size_t i = first; i < last; i++) {
+            if (entered[reached[i]] != 0) { waiting.push_back(reached[i]); }
+        }
+        std::make_heap(waiting.begin(), waiting.end(), later);
+        while (!waiting.empty()) {
+            std::pop_heap(waiting.begin(), waiting.end(), later);
+            int v = waiting.back();
+            waiting.pop_back();
+            if (rank[v] != -1) { continue; }
+            rank[v] = settled++;
+            for (int i = zeroOffsets[v]; i < zeroOffsets[v + 1]; i++) {
+                if (rank[zeroTargets[i]] == -1) {
+                    waiting.push_back(zeroTargets[i]);
+                    std::push_heap(waiting.begin(), waiting.end(), later);
+                }
+            }
+        }
+        first = last;
+    }
+    for (const TightEdge& edge : tight) {
+        int u = edge.to;
+        if (rank[edge.from] == -1) { continue; }
+        if (previous[u] == -1 || rank[edge.from] < rank[previous[u]]) {
+            previous[u] = edge.from;
+        }
+    }
+}
+
+/** queue-based Bellman-Ford (SPFA) starting from every vertex in sources
+    at cost 0, see bellmanFord */
+template <typename GraphView>
+bool spfa(const GraphView& graph, const std::vector<int>& sources,
+          std::vector<long long>& cost, std::vector<int>& previous) {
+    int n = graph.getNumVertices();
+    const std::vector<long long>& offsets = graph.getOffsets();
+    const std::vector<int>& targets = graph.getTargets();
+    const std::vector<int>& weights = graph.getWeights();
+    cost.assign(n, kUnreachable);
+    previous.assign(n, -1);
+    // edges on the path that gave each cost, n or more means a cycle
+    std::vector<int> hops(n, 0);
+    std::vector<char> queued(n, 0);
+    // circular queue, at most n vertices are waiting at once
+    std::vector<int> queue(n);
+    std::vector<int> improved;
+    size_t head = 0;
+    size_t waiting = 0;
+    for (int source : sources) {
+        if (queued[source] != 0) { continue; }
+        queue[waiting++] = source;
+        queued[source] = 1;
+        cost[source] = 0;
+    }
+    while (waiting > 0) {
+        int v = queue[head];
+        head = (head + 1) % n;
+        waiting--;
+        queued[v] = 0;
+        int degree = static_cast<int>(offsets[v + 1] - offsets[v]);
+        improved.resize(degree);
+        int found = relaxkernel::relaxEdges(
+            cost[v], targets.data() + offsets[v], weights.data() + offsets[v],
+            degree, cost.data(), improved.data());
+        for (int k = 0; k < found; k++) {
+            long long i = offsets[v] + improved[k];
+            int u = targets[i];
+            cost[u] = cost[v] + weights[i];
+            previous[u] = v;
+            hops[u] = hops[v] + 1;
+            if (hops[u] >= n) { return false; }
+            if (queued[u] == 0) {
+                queued[u] = 1;
+                queue[(head + waiting) % n] = u;
+                waiting++;
+            }
+        }
+    }
+    return true;
+}
+
+/** Dijkstra settling vertices by cost minus potential, which is Dijkstra
+    on the Johnson-reweighted graph without building it: reweighted
+    edges w + potential[v] - potential[u] are never negative, a path to u
+    costs potential[start] - potential[u] more than before, and the
+    costs found are the original ones
+    improved is work space, ties go to the lower ID */
+template <typename GraphView>
+void dijkstraWithPotential(const GraphView& graph, int startId,
+                           const std::vector<long long>& potential,
+                           std::vector<long long>& cost,
+                           std::vector<int>& previous,
+                           std::vector<int>& improved) {
+    const std::vector<long long>& offsets = graph.getOffsets();
+    const std::vector<int>& targets = graph.getTargets();
+    const std::vector<int>& weights = graph.getWeights();
+    cost.assign(graph.getNumVertices(), kUnreachable);
+    previous.assign(graph.getNumVertices(), -1);
+    std::vector<char> settled(graph.getNumVertices(), 0);
+    using Entry = std::pair<long long, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+    cost[startId] = 0;
+    pq.push({-potential[startId], startId});
+    while (!pq.empty()) {
+        int v = pq.top().second;
+        pq.pop();
+        if (settled[v] != 0) { continue; }
+        settled[v] = 1;
+        int degree = static_cast<int>(offsets[v + 1] - offsets[v]);
+        improved.resize(degree);
+        int found = relaxkernel::relaxEdges(
+            cost[v], targets.data() + offsets[v], weights.data() + offsets[v],
+            degree, cost.data(), improved.data());
+        for (int k = 0; k < found; k++) {
+            long long i = offsets[v] + improved[k];
+            int u = targets[i];
+            if (settled[u] != 0) { continue; }
+            cost[u] = cost[v] + weights[i];
+            previous[u] = v;
+            pq.push({cost[u] - potential[u], u});
+        }
+    }
+}
+
+}  // namespace detail
+
+/** lowest cost from startId to every vertex when weights may be negative,
+    using queue-based Bellman-Ford (SPFA) over flat adjacency arrays as in
+    dijkstraCsr, relaxing edges with relaxkernel
+    results as in dijkstra, but previous[v] is the last vertex that
+    lowered v's cost, not picked by label
+    returns false if a negative cycle can be reached from startId, cost
+    and previous are then unspecified */
+template <typename GraphView>
+bool bellmanFord(const GraphView& graph, int startId,
+                 std::vector<long long>& cost, std::vector<int>& previous) {
+    return detail::spfa(graph, {startId}, cost, previous);
+}
+
+/** lowest cost between every pair of vertices when weights may be
+    negative, using Johnson's algorithm over flat adjacency arrays as in
+    dijkstraCsr
+    one Bellman-Ford pass from all vertices at once gives potentials that
+    make every edge non-negative, then each source runs Dijkstra, spread
+    over pool if given
+    cost[s][v] and previous[s][v] are as dijkstra gives for start s, but
+    equally cheap predecessors are picked by ID instead of label
+    needs n * n entries in each of cost and previous
+    returns false if the graph has a negative cycle, cost and previous
+    are then empty */
+template <typename GraphView>
+bool johnson(const GraphView& graph,
+             std::vector<std::vector<long long>>& cost,
+             std::vector<std::vector<int>>& previous,
+             ThreadPool* pool = nullptr) {
+    int n = graph.getNumVertices();
+    cost.clear();
+    previous.clear();
+    std::vector<int> everyVertex(n);
+    for (int v = 0; v < n; v++) { everyVertex[v] = v; }
+    std::vector<long long> potential;
+    std::vector<int> unused;
+    if (!detail::spfa(graph, everyVertex, potential, unused)) { return false; }
+    cost.resize(n);
+    previous.resize(n);
+    auto runSources = [&](long long first, long long last) {
+        std::vector<int> improved;
+        for (long long s = first; s < last; s++) {
+            detail::dijkstraWithPotential(graph, static_cast<int>(s),
+                                          potential, cost[s], previous[s],
+                                          improved);
+        }
+    };
+    if (pool == nullptr) {
+        runSources(0, n);
+    } else {
+        pool->parallelFor(0, n, 1, runSources);
+    }
+    return true;
+}
+
+/** dijkstra with label-keyed results, as in Graph::djikstraCostToAllVertices
+    weight["F"] = 10 indicates the cost to get to "F" is 10
+    previous["F"] = "C" indicates get to "F" via "C"
+    unreachable vertices are left out, and so is the start vertex unless
+    a cycle leads back to it */
+template <typename GraphView>
+void dijkstra(const GraphView& graph, int startId,
+              std::map<std::string, int>& weight,
+              std::map<std::string, std::string>& previous) {
+    std::vector<long long> cost;
+    std::vector<int> previousId;
+    dijkstra(graph, startId, cost, previousId);
+    toLabels(graph, startId, cost, previousId, weight, previous,
+             cycleCost(graph, startId, cost, previousId));
+}
+
+/** dijkstraCsr with label-keyed results, as in the dijkstra overload
+    above, weight can hold int or long long costs */
+template <typename GraphView, typename Cost>
+void dijkstraCsr(const GraphView& graph, int startId,
+                 std::map<std::string, Cost>& weight,
+                 std::map<std::string, std::string>& previous,
+                 ThreadPool* pool = nullptr) {
+    std::vector<long long> cost;
+    std::vector<int> previousId;
+    dijkstraCsr(graph, startId, cost, previousId, pool);
+    toLabels(graph, startId, cost, previousId, weight, previous,
+             cycleCost(graph, startId, cost, previousId));
+}
+
+}  // namespace shortestpath
+
+#endif  // SHORTESTPATH_H
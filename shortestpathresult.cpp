@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include "shortestpathresult.h"
+
+/**
+ * Result of a single-source shortest-path search on a Graph
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+/** return the ID of the start vertex, -1 if it did not exist */
+int ShortestPathResult::getStartId() const {
+    return startId;
+}
+
+/** return number of vertices of the graph searched */
+int ShortestPathResult::getNumVertices() const {
+    return static_cast<int>(cost.size());
+}
+
+/** return the ID of the vertex with label, -1 if it does not exist */
+int ShortestPathResult::findId(const std::string& vertexLabel) const {
+    return view == nullptr ? -1 : view->findId(vertexLabel);
+}
+
+/** return the label of the vertex with the given ID */
+const std::string& ShortestPathResult::getLabel(int id) const {
+    return view->getLabel(id);
+}
+
+/** return true if vertex id can be reached from the start */
+bool ShortestPathResult::isReachable(int id) const {
+    return getCost(id) != shortestpath::kUnreachable;
+}
+
+/** return the lowest cost to vertex id */
+long long ShortestPathResult::getCost(int id) const {
+    if (id < 0 || id >= getNumVertices()) {
+        return shortestpath::kUnreachable;
+    }
+    return cost[id];
+}
+
+/** return the lowest cost to the vertex with label */
+long long ShortestPathResult::getCost(const std::string& vertexLabel) const {
+    return getCost(findId(vertexLabel));
+}
+
+/** return the ID of the vertex before id on its cheapest path */
+int ShortestPathResult::getPreviousId(int id) const {
+    return isReachable(id) ? previous[id] : -1;
+}
+
+/** return costs of all vertices by ID */
+const std::vector<long long>& ShortestPathResult::getCosts() const {
+    return cost;
+}
+
+/** return previous vertex IDs of all vertices by ID */
+const std::vector<int>& ShortestPathResult::getPreviousIds() const {
+    return previous;
+}
+
+/** return the IDs on the cheapest path from the start to id */
+std::vector<int> ShortestPathResult::getPathIds(int id) const {
+    std::vector<int> path;
+    if (!isReachable(id)) { return path; }
+    // previous of the start may close a cycle, so stop there
+    for (int v = id;; v = previous[v]) {
+        path.push_back(v);
+        if (v == startId) { break; }
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+/** return the labels on the cheapest path from the start to vertexLabel */
+std::vector<std::string> ShortestPathResult::getPath(
+    const std::string& vertexLabel) const {
+    std::vector<std::string> path;
+    int id = findId(vertexLabel);
+    if (id == -1) { return path; }
+    for (int v : getPathIds(id)) { path.push_back(getLabel(v)); }
+    return path;
+}
@@ -0,0 +1,118 @@
+/**
+ * Result of a single-source shortest-path search on a Graph
+ * Costs and predecessors are kept in flat arrays indexed by vertex ID,
+ * and labels are only looked up when asked for, so a search does no
+ * string work at all. Reusing one result for many searches keeps its
+ * arrays, and the search's own settled marks and heap, which are only
+ * reallocated when the graph has grown
+ * A default-constructed result has no vertices: every ID is out of
+ * range, and IDs out of range cannot be reached
+ * The result holds on to the CsrGraph copy it was computed on, so
+ * labels and IDs stay those of the graph at the time of the search
+ */
+
+#ifndef SHORTESTPATHRESULT_H
+#define SHORTESTPATHRESULT_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "csrgraph.h"
+#include "shortestpath.h"
+
+class ShortestPathResult {
+    friend class Graph;
+
+ public:
+    /** empty result, as for a start vertex that does not exist */
+    ShortestPathResult() = default;
+
+    /** return the ID of the start vertex, -1 if it did not exist */
+    int getStartId() const;
+
+    /** return number of vertices of the graph searched */
+    int getNumVertices() const;
+
+    /** return the ID of the vertex with label, -1 if it does not exist */
+    int findId(const std::string& vertexLabel) const;
+
+    /** return the label of the vertex with the given ID, which must be
+        from 0 to getNumVertices() - 1 */
+    const std::string& getLabel(int id) const;
+
+    /** return true if vertex id can be reached from the start, false
+        for IDs out of range */
+    bool isReachable(int id) const;
+
+    /** return the lowest cost to vertex id,
+        shortestpath::kUnreachable if it cannot be reached or is out of
+        range */
+    long long getCost(int id) const;
+
+    /** return the lowest cost to the vertex with label,
+        shortestpath::kUnreachable if it cannot be reached or does not
+        exist */
+    long long getCost(const std::string& vertexLabel) const;
+
+    /** return the ID of the vertex before id on its cheapest path,
+        -1 for vertices that cannot be reached or are out of range; for
+        the start, the vertex closing the cheapest cycle back to it, -1
+        if there is none */
+    int getPreviousId(int id) const;
+
+    /** return costs of all vertices by ID */
+    const std::vector<long long>& getCosts() const;
+
+    /** return previous vertex IDs of all vertices by ID */
+    const std::vector<int>& getPreviousIds() const;
+
+    /** return the IDs on the cheapest path from the start to id, both
+        ends included, empty if id cannot be reached or is out of range */
+    std::vector<int> getPathIds(int id) const;
+
+    /** return the labels on the cheapest path from the start to
+        vertexLabel, both ends included, empty if it cannot be reached */
+    std::vector<std::string> getPath(const std::string& vertexLabel) const;
+
+    /** fill maps as Graph::djikstraCostToAllVertices always has,
+        leaving out vertices that cannot be reached, and the start
+        unless a cycle leads back to it
+        weight can hold int or long long costs */
+    template <typename Cost>
+    void toMaps(std::map<std::string, Cost>& weight,
+                std::map<std::string, std::string>& previous) const;
+
+ private:
+    /** graph copy searched, nullptr before the first search */
+    std::shared_ptr<const CsrGraph> view;
+
+    /** ID of the start vertex, -1 if none */
+    int startId {-1};
+
+    /** lowest cost by vertex ID */
+    std::vector<long long> cost;
+
+    /** previous vertex ID on the cheapest path, by vertex ID */
+    std::vector<int> previous;
+
+    /** scratch space of the search, reused by the next one */
+    shortestpath::DijkstraWorkspace workspace;
+};  // end ShortestPathResult
+
+/** fill maps as Graph::djikstraCostToAllVertices always has */
+template <typename Cost>
+void ShortestPathResult::toMaps(
+    std::map<std::string, Cost>& weight,
+    std::map<std::string, std::string>& previous) const {
+    weight.clear();
+    previous.clear();
+    if (startId != -1) {
+        shortestpath::toLabels(
+            *view, startId, cost, this->previous, weight, previous,
+            shortestpath::cycleCost(*view, startId, cost, this->previous));
+    }
+}
+
+#endif  // SHORTESTPATHRESULT_H
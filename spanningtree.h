@@ -0,0 +1,342 @@
+/**
+ * Minimum spanning forests of any graph view (see traversal.h)
+ * Edges are taken as undirected. When both directions of an edge exist
+ * the MergeRule picks which weight the undirected edge gets
+ * Ties between equal weights are broken by the IDs of the ends, so every
+ * edge has its own place in one order and the forest is unique: prim,
+ * kruskal and boruvka all return the same edges, sorted in that order
+ *
+ * prim grows each tree from its lowest ID vertex with an indexed heap,
+ * so a vertex is in the heap at most once and its key is lowered in
+ * place. kruskal adds edges cheapest first, joining trees in a
+ * union-find with path compression. boruvka joins every tree to its
+ * cheapest neighbor each round, halving the number of trees at least;
+ * the search for cheapest edges, the bulk of the work, can be spread
+ * over a ThreadPool
+ */
+
+#ifndef SPANNINGTREE_H
+#define SPANNINGTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <utility>
+#include <vector>
+
+#include "threadpool.h"
+
+namespace spanningtree {
+
+/** weight of an undirected edge that exists in both directions */
+enum class MergeRule { Min, Max };
+
+/** an edge of the forest, start has the smaller ID */
+struct TreeEdge {
+    int start;
+    int end;
+    int weight;
+};
+
+/** a minimum spanning forest, one tree per connected part of the graph
+    a vertex without edges is a tree on its own */
+struct SpanningForest {
+    std::vector<TreeEdge> edges;
+    long long totalWeight {0};
+    int numTrees {0};
+};
+
+namespace detail {
+
+/** the undirected edges of graph without self-loops, each once, in
+    order of weight, then start, then end */
+template <typename GraphView>
+std::vector<TreeEdge> undirectedEdges(const GraphView& graph,
+                                      MergeRule rule) {
+    std::vector<TreeEdge> edges;
+    for (int v = 0; v < graph.getNumVertices(); v++) {
+        graph.forEachNeighbor(v, [&](int u, int edgeWeight) {
+            if (u != v) {
+                edges.push_back({std::min(u, v), std::max(u, v), edgeWeight});
+            }
+            return true;
+        });
+    }
+    // both directions of an edge end up next to each other
+    std::sort(edges.begin(), edges.end(),
+              [](const TreeEdge& a, const TreeEdge& b) {
+        if (a.start != b.start) { return a.start < b.start; }
+        if (a.end != b.end) { return a.end < b.end; }
+        return a.weight < b.weight;
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < edges.size(); i++) {
+        if (kept > 0 && edges[kept - 1].start == edges[i].start &&
+            edges[kept - 1].end == edges[i].end) {
+            // sorted by weight, so the later one is the larger
+            if (rule == MergeRule::Max) { edges[kept - 1] = edges[i]; }
+            continue;
+        }
+        edges[kept++] = edges[i];
+    }
+    edges.resize(kept);
+    std::sort(edges.begin(), edges.end(),
+              [](const TreeEdge& a, const TreeEdge& b) {
+        if (a.weight != b.weight) { return a.weight < b.weight; }
+        if (a.start != b.start) { return a.start < b.start; }
+        return a.end < b.end;
+    });
+    return edges;
+}
+
+/** disjoint sets of vertices, joined by size */
+class UnionFind {
+ public:
+    /** n sets of one vertex each */
+    explicit UnionFind(int n) : parent(n), size(n, 1) {
+        for (int v = 0; v < n; v++) { parent[v] = v; }
+    }
+
+    /** return the root of v's set, pointing everything on the way at it */
+    int find(int v) {
+        int root = v;
+        while (parent[root] != root) { root = parent[root]; }
+        while (parent[v] != root) {
+            int next = parent[v];
+            parent[v] = root;
+            v = next;
+        }
+        return root;
+    }
+
+    /** join the sets of a and b, returns false if already joined */
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) { return false; }
+        if (size[a] < size[b]) { std::swap(a, b); }
+        parent[b] = a;
+        size[a] += size[b];
+        return true;
+    }
+
+ private:
+    std::vector<int> parent;
+    std::vector<int> size;
+};  // end UnionFind
+
+/** binary min-heap of vertices that knows where each vertex is, so
+    a key can be lowered in place */
+class IndexedHeap {
+ public:
+    /** empty heap for vertices 0 to n - 1 */
+    explicit IndexedHeap(int n) : key(n), place(n, -1) {}
+
+    /** return true if there are no vertices in the heap */
+    bool empty() const { return heap.empty(); }
+
+    /** return true if v is in the heap */
+    bool contains(int v) const { return place[v] != -1; }
+
+    /** return the key of v, which must be in the heap */
+    int getKey(int v) const { return key[v]; }
+
+    /** add v with newKey, or lower its key to newKey */
+    void pushOrLower(int v, int newKey) {
+        key[v] = newKey;
+        if (place[v] == -1) {
+            place[v] = static_cast<int>(heap.size());
+            heap.push_back(v);
+        }
+        siftUp(place[v]);
+    }
+
+    /** remove and return the vertex with the lowest key */
+    int pop() {
+        int top = heap.front();
+        place[top] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            place[last] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+
+ private:
+    /** move the vertex at i up while its key is lower than its parent's */
+    void siftUp(int i) {
+        while (i > 0) {
+            int up = (i - 1) / 2;
+            if (key[heap[up]] <= key[heap[i]]) { return; }
+            swapPlaces(i, up);
+            i = up;
+        }
+    }
+
+    /** move the vertex at i down while a child has a lower key */
+    void siftDown(int i) {
+        int size = static_cast<int>(heap.size());
+        while (true) {
+            int lowest = i;
+            for (int child = 2 * i + 1; child <= 2 * i + 2; child++) {
+                if (child < size && key[heap[child]] < key[heap[lowest]]) {
+                    lowest = child;
+                }
+            }
+            if (lowest == i) { return; }
+            swapPlaces(i, lowest);
+            i = lowest;
+        }
+    }
+
+    /** swap the vertices at places i and j */
+    void swapPlaces(int i, int j) {
+        std::swap(heap[i], heap[j]);
+        place[heap[i]] = i;
+        place[heap[j]] = j;
+    }
+
+    std::vector<int> heap;
+    std::vector<int> key;
+    std::vector<int> place;
+};  // end IndexedHeap
+
+/** forest from the chosen edges, given by their place in edges */
+inline SpanningForest makeForest(const std::vector<TreeEdge>& edges,
+                                 std::vector<int>& chosen, int n) {
+    std::sort(chosen.begin(), chosen.end());
+    SpanningForest forest;
+    forest.edges.reserve(chosen.size());
+    for (int e : chosen) {
+        forest.edges.push_back(edges[e]);
+        forest.totalWeight += edges[e].weight;
+    }
+    forest.numTrees = n - static_cast<int>(chosen.size());
+    return forest;
+}
+
+}  // namespace detail
+
+/** minimum spanning forest with Prim's algorithm and an indexed heap */
+template <typename GraphView>
+SpanningForest prim(const GraphView& graph,
+                    MergeRule rule = MergeRule::Min) {
+    int n = graph.getNumVertices();
+    std::vector<TreeEdge> edges = detail::undirectedEdges(graph, rule);
+    // undirected adjacency lists holding places in edges, which are
+    // also the keys: a lower place is a cheaper edge
+    std::vector<int> offsets(n + 1, 0);
+    for (const TreeEdge& edge : edges) {
+        offsets[edge.start + 1]++;
+        offsets[edge.end + 1]++;
+    }
+    for (int v = 0; v < n; v++) { offsets[v + 1] += offsets[v]; }
+    std::vector<int> incident(offsets[n]);
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (int e = 0; e < static_cast<int>(edges.size()); e++) {
+        incident[next[edges[e].start]++] = e;
+        incident[next[edges[e].end]++] = e;
+    }
+    std::vector<char> inTree(n, 0);
+    std::vector<int> chosen;
+    detail::IndexedHeap heap(n);
+    for (int root = 0; root < n; root++) {
+        if (inTree[root]) { continue; }
+        inTree[root] = 1;
+        int v = root;
+        while (true) {
+            for (int i = offsets[v]; i < offsets[v + 1]; i++) {
+                int e = incident[i];
+                int u = edges[e].start == v ? edges[e].end : edges[e].start;
+                if (!inTree[u] && (!heap.contains(u) || e < heap.getKey(u))) {
+                    heap.pushOrLower(u, e);
+                }
+            }
+            if (heap.empty()) { break; }
+            v = heap.pop();
+            inTree[v] = 1;
+            chosen.push_back(heap.getKey(v));
+        }
+    }
+    return detail::makeForest(edges, chosen, n);
+}
+
+/** minimum spanning forest with Kruskal's algorithm */
+template <typename GraphView>
+SpanningForest kruskal(const GraphView& graph,
+                       MergeRule rule = MergeRule::Min) {
+    int n = graph.getNumVertices();
+    std::vector<TreeEdge> edges = detail::undirectedEdges(graph, rule);
+    detail::UnionFind trees(n);
+    std::vector<int> chosen;
+    for (int e = 0; e < static_cast<int>(edges.size()); e++) {
+        if (trees.unite(edges[e].start, edges[e].end)) {
+            chosen.push_back(e);
+            if (static_cast<int>(chosen.size()) == n - 1) { break; }
+        }
+    }
+    return detail::makeForest(edges, chosen, n);
+}
+
+/** minimum spanning forest with Boruvka's algorithm, finding the
+    cheapest edge out of each tree on pool if given */
+template <typename GraphView>
+SpanningForest boruvka(const GraphView& graph,
+                       MergeRule rule = MergeRule::Min,
+                       ThreadPool* pool = nullptr) {
+    constexpr long long kGrain = 4096;
+    int n = graph.getNumVertices();
+    std::vector<TreeEdge> edges = detail::undirectedEdges(graph, rule);
+    // edges still joining two trees, by place in edges
+    std::vector<int> live(edges.size());
+    for (int e = 0; e < static_cast<int>(edges.size()); e++) { live[e] = e; }
+    std::vector<int> tree(n);
+    for (int v = 0; v < n; v++) { tree[v] = v; }
+    std::vector<std::atomic<int>> cheapest(n);
+    detail::UnionFind trees(n);
+    std::vector<int> chosen;
+    while (!live.empty()) {
+        for (auto& e : cheapest) {
+            e.store(INT_MAX, std::memory_order_relaxed);
+        }
+        // a lower place is a cheaper edge, so keep the lowest per tree
+        auto lower = [&cheapest](int t, int e) {
+            int seen = cheapest[t].load(std::memory_order_relaxed);
+            while (e < seen &&
+                   !cheapest[t].compare_exchange_weak(
+                       seen, e, std::memory_order_relaxed)) {}
+        };
+        auto scan = [&](long long first, long long last) {
+            for (long long i = first; i < last; i++) {
+                const TreeEdge& edge = edges[live[i]];
+                lower(tree[edge.start], live[i]);
+                lower(tree[edge.end], live[i]);
+            }
+        };
+        if (pool == nullptr) {
+            scan(0, static_cast<long long>(live.size()));
+        } else {
+            pool->parallelFor(0, static_cast<long long>(live.size()), kGrain,
+                              scan);
+        }
+        // two trees may pick the same edge; unite adds it once
+        for (int t = 0; t < n; t++) {
+            int e = cheapest[t].load(std::memory_order_relaxed);
+            if (e != INT_MAX && trees.unite(edges[e].start, edges[e].end)) {
+                chosen.push_back(e);
+            }
+        }
+        for (int v = 0; v < n; v++) { tree[v] = trees.find(v); }
+        live.erase(std::remove_if(live.begin(), live.end(), [&](int e) {
+            return tree[edges[e].start] == tree[edges[e].end];
+        }), live.end());
+    }
+    return detail::makeForest(edges, chosen, n);
+}
+
+}  // namespace spanningtree
+
+#endif  // SPANNINGTREE_H
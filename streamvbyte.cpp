@@ -0,0 +1,207 @@
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#include "cpufeatures.h"
+#include "streamvbyte.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STREAMVBYTE_X86 1
+#include <immintrin.h>
+#else
+#define STREAMVBYTE_X86 0
+#endif
+
+/**
+ * Stream VByte coding of 32-bit integers
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace streamvbyte {
+
+namespace {
+
+/** bytes used by the 4 values a control byte describes */
+struct Tables {
+    std::array<uint8_t, 256> length;
+    /** byte shuffle that spreads the value bytes into 4 lanes,
+        0x80 (zero) for the unused high bytes */
+    alignas(16) std::array<std::array<uint8_t, 16>, 256> shuffle;
+
+    Tables() {
+        for (int control = 0; control < 256; control++) {
+            int next = 0;
+            for (int lane = 0; lane < 4; lane++) {
+                int bytes = ((control >> (2 * lane)) & 3) + 1;
+                for (int b = 0; b < 4; b++) {
+                    shuffle[control][lane * 4 + b] =
+                        b < bytes ? static_cast<uint8_t>(next + b) : 0x80;
+                }
+                next += bytes;
+            }
+            length[control] = static_cast<uint8_t>(next);
+        }
+    }
+};
+
+const Tables tables;
+
+/** bytes needed for value, as the 2-bit code */
+uint8_t code(uint32_t value) {
+    if (value < (1u << 8)) { return 0; }
+    if (value < (1u << 16)) { return 1; }
+    if (value < (1u << 24)) { return 2; }
+    return 3;
+}
+
+/** decode one value of code bytes, little-endian */
+uint32_t readValue(const uint8_t* data, int bytes) {
+    uint32_t value = 0;
+    for (int b = 0; b < bytes; b++) {
+        value |= static_cast<uint32_t>(data[b]) << (8 * b);
+    }
+    return value;
+}
+
+/** plain decoder, one value at a time */
+size_t decodeScalar(const uint8_t* controls, const uint8_t* data,
+                    size_t count, uint32_t* values) {
+    const uint8_t* start = data;
+    for (size_t i = 0; i < count; i++) {
+        int bytes = ((controls[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        values[i] = readValue(data, bytes);
+        data += bytes;
+    }
+    return data - start;
+}
+
+#if STREAMVBYTE_X86
+
+/** four values per shuffle, the rest with the plain decoder */
+__attribute__((target("ssse3")))
+size_t decodeSsse3(const uint8_t* controls, const uint8_t* data,
+                   size_t count, uint32_t* values) {
+    const uint8_t* start = data;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint8_t control = controls[i / 4];
+        __m128i bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data));
+        __m128i mask = _mm_load_si128(
+            reinterpret_cast<const __m128i*>(tables.shuffle[control].data()));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i),
+                         _mm_shuffle_epi8(bytes, mask));
+        data += tables.length[control];
+    }
+    return (data - start) + decodeScalar(controls + i / 4, data, count - i,
+                                         values + i);
+}
+
+#endif  // STREAMVBYTE_X86
+
+/** running totals of values, starting from previous */
+void prefixSum(uint32_t* values, size_t count, uint32_t previous) {
+    size_t i = 0;
+#if STREAMVBYTE_X86
+    // SSE2 is part of x86-64, no dispatch needed
+    __m128i carry = _mm_set1_epi32(static_cast<int>(previous));
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i*>(values + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), x);
+        carry = _mm_shuffle_epi32(x, 0xFF);
+    }
+    if (i > 0) { previous = values[i - 1]; }
+#endif
+    for (; i < count; i++) {
+        previous += values[i];
+        values[i] = previous;
+    }
+}
+
+/** widest kernel the CPU supports */
+Kernel detectKernel() {
+    return isSupported(Kernel::Ssse3) ? Kernel::Ssse3 : Kernel::Scalar;
+}
+
+/** kernel decode dispatches to */
+std::atomic<Kernel> activeKernel {detectKernel()};
+
+}  // namespace
+
+/** return true if this CPU and build can run kernel */
+bool isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Ssse3:
+            return cpufeatures::has(cpufeatures::Feature::Ssse3);
+        case Kernel::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** return the kernel decode uses */
+Kernel getKernel() {
+    return activeKernel.load(std::memory_order_relaxed);
+}
+
+/** make decode use kernel */
+bool setKernel(Kernel kernel) {
+    if (!isSupported(kernel)) { return false; }
+    activeKernel.store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+/** append the control bytes and then the value bytes of count values */
+void encode(const uint32_t* values, size_t count, std::vector<uint8_t>& out) {
+    size_t controlStart = out.size();
+    out.resize(controlStart + controlLength(count), 0);
+    for (size_t i = 0; i < count; i++) {
+        uint8_t c = code(values[i]);
+        out[controlStart + i / 4] |= static_cast<uint8_t>(c << (2 * (i % 4)));
+        for (int b = 0; b <= c; b++) {
+            out.push_back(static_cast<uint8_t>(values[i] >> (8 * b)));
+        }
+    }
+}
+
+/** number of value bytes described by the control bytes of count values */
+size_t dataLength(const uint8_t* controls, size_t count) {
+    size_t length = 0;
+    for (size_t c = 0; c < count / 4; c++) {
+        length += tables.length[controls[c]];
+    }
+    for (size_t i = count / 4 * 4; i < count; i++) {
+        length += ((controls[i / 4] >> (2 * (i % 4))) & 3) + 1;
+    }
+    return length;
+}
+
+/** decode count values */
+size_t decode(const uint8_t* controls, const uint8_t* data, size_t count,
+              uint32_t* values) {
+#if STREAMVBYTE_X86
+    if (getKernel() == Kernel::Ssse3) {
+        return decodeSsse3(controls, data, count, values);
+    }
+#endif
+    return decodeScalar(controls, data, count, values);
+}
+
+/** decode gaps and turn them into running totals starting from previous */
+size_t decodeDelta(const uint8_t* controls, const uint8_t* data,
+                   size_t count, uint32_t previous, uint32_t* values) {
+    size_t read = decode(controls, data, count, values);
+    prefixSum(values, count, previous);
+    return read;
+}
+
+}  // namespace streamvbyte
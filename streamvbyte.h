@@ -0,0 +1,60 @@
+/**
+ * Stream VByte coding of 32-bit integers
+ * Values are stored in 1 to 4 bytes each. The lengths go in separate
+ * control bytes, 2 bits per value and 4 values per control byte, ahead
+ * of the value bytes, so a decoder can find 4 values with one table
+ * lookup. The SSSE3 decoder expands 4 values with a single byte shuffle;
+ * the version used is picked at run time from what the CPU supports,
+ * with a plain loop as fallback
+ * Decoders may read up to kPadding bytes past the last value byte
+ */
+
+#ifndef STREAMVBYTE_H
+#define STREAMVBYTE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace streamvbyte {
+
+/** bytes a buffer must have after the last value byte */
+constexpr size_t kPadding = 16;
+
+/** implementations of decode */
+enum class Kernel { Scalar, Ssse3 };
+
+/** return true if this CPU and build can run kernel */
+bool isSupported(Kernel kernel);
+
+/** return the kernel decode uses, the widest supported by default */
+Kernel getKernel();
+
+/** make decode use kernel, for testing and benchmarks
+    returns false and changes nothing if kernel is not supported */
+bool setKernel(Kernel kernel);
+
+/** number of control bytes for count values */
+inline size_t controlLength(size_t count) { return (count + 3) / 4; }
+
+/** append the control bytes and then the value bytes of count values */
+void encode(const uint32_t* values, size_t count, std::vector<uint8_t>& out);
+
+/** number of value bytes described by the control bytes of count values */
+size_t dataLength(const uint8_t* controls, size_t count);
+
+/** decode count values whose lengths start at controls and bytes start
+    at data; count must be a multiple of 4 unless it reaches the end of
+    the encoded values
+    returns the number of value bytes read */
+size_t decode(const uint8_t* controls, const uint8_t* data, size_t count,
+              uint32_t* values);
+
+/** decode as above, and turn gaps into running totals starting from
+    previous: values[i] = previous + gap[0] + ... + gap[i] */
+size_t decodeDelta(const uint8_t* controls, const uint8_t* data,
+                   size_t count, uint32_t previous, uint32_t* values);
+
+}  // namespace streamvbyte
+
+#endif  // STREAMVBYTE_H
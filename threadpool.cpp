@@ -0,0 +1,235 @@
+#include <random>
+
+#include "threadpool.h"
+
+/**
+ * Work-stealing thread pool shared by the parallel graph algorithms
+ */
+
+
+////////////////////////////////////////////////////////////////////////////////
+// This is 80 characters - Keep all lines under 80 characters                 //
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace {
+
+/** steady_clock time in nanoseconds */
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** pool the current thread works for, nullptr for other threads */
+thread_local const ThreadPool* currentPool = nullptr;
+
+/** index of the current thread in currentPool */
+thread_local int currentIndex = -1;
+
+}  // namespace
+
+/** start numThreads workers, at least one */
+ThreadPool::ThreadPool(int numThreads) {
+    numThreads = std::max(1, numThreads);
+    statsStart = nowNanos();
+    for (int w = 0; w < numThreads; w++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int w = 0; w < numThreads; w++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, w);
+    }
+}
+
+/** finish queued tasks and stop the workers */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(injectLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) { thread.join(); }
+}
+
+/** return number of worker threads */
+int ThreadPool::getNumThreads() const {
+    return static_cast<int>(workers.size());
+}
+
+/** index of the calling worker in this pool, -1 for other threads */
+int ThreadPool::currentWorker() const {
+    return currentPool == this ? currentIndex : -1;
+}
+
+/** counters for each worker */
+std::vector<ThreadPool::WorkerStats> ThreadPool::getStats() const {
+    int64_t elapsed = nowNanos() - statsStart.load();
+    std::vector<WorkerStats> stats;
+    for (const auto& worker : workers) {
+        WorkerStats s;
+        s.tasksRun = worker->tasksRun;
+        s.tasksStolen = worker->tasksStolen;
+        s.itemsRun = worker->itemsRun;
+        s.busyTime = std::chrono::nanoseconds(worker->busyNanos.load());
+        if (elapsed > 0) {
+            s.utilization = std::min(1.0,
+                static_cast<double>(s.busyTime.count()) / elapsed);
+        }
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+/** zero the counters and restart the utilization clock */
+void ThreadPool::resetStats() {
+    for (auto& worker : workers) {
+        worker->tasksRun = 0;
+        worker->tasksStolen = 0;
+        worker->itemsRun = 0;
+        worker->busyNanos = 0;
+    }
+    statsStart = nowNanos();
+}
+
+/** run job over [begin, end) and wait for it */
+void ThreadPool::runJob(Job& job, long long begin, long long end) {
+    int self = currentWorker();
+    if (self != -1) {
+        // nested call: seed our own deque and keep working while waiting
+        {
+            std::lock_guard<std::mutex> lock(workers[self]->lock);
+            workers[self]->tasks.push_back({&job, begin, end});
+        }
+        announceTask();
+        Task task;
+        while (!job.finished.load()) {
+            if (findTask(self, task)) {
+                execute(self, task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        // wait for the finisher to let go of the lock before job goes away
+        std::lock_guard<std::mutex> lock(job.doneLock);
+        if (job.error) { std::rethrow_exception(job.error); }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(injectLock);
+        injected.push_back({&job, begin, end});
+        queued++;
+    }
+    wake.notify_one();
+    std::unique_lock<std::mutex> lock(job.doneLock);
+    job.done.wait(lock, [&job] { return job.finished.load(); });
+    if (job.error) { std::rethrow_exception(job.error); }
+}
+
+/** split task down to job grain, then run what is left */
+void ThreadPool::execute(int worker, Task task) {
+    Worker& self = *workers[worker];
+    auto started = std::chrono::steady_clock::now();
+    Job* job = task.job;
+    while (task.end - task.begin > job->grain) {
+        long long mid = task.begin + (task.end - task.begin) / 2;
+        {
+            std::lock_guard<std::mutex> lock(self.lock);
+            self.tasks.push_back({job, mid, task.end});
+        }
+        announceTask();
+        task.end = mid;
+    }
+    if (!job->failed.load()) {
+        try {
+            job->run(job->body, task.begin, task.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job->doneLock);
+            if (!job->error) { job->error = std::current_exception(); }
+            job->failed = true;
+        }
+    }
+    self.tasksRun++;
+    self.itemsRun += task.end - task.begin;
+    self.busyNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    // the last piece wakes the caller, job may be gone once the lock is
+    // released so nothing touches it after that
+    if (job->remaining.fetch_sub(task.end - task.begin) ==
+        task.end - task.begin) {
+        std::lock_guard<std::mutex> lock(job->doneLock);
+        job->finished = true;
+        job->done.notify_all();
+    }
+}
+
+/** take a task: own deque bottom, then shared queue, then steal */
+bool ThreadPool::findTask(int worker, Task& task) {
+    if (queued.load() == 0) { return false; }
+    {
+        Worker& self = *workers[worker];
+        std::lock_guard<std::mutex> lock(self.lock);
+        if (!self.tasks.empty()) {
+            task = self.tasks.back();
+            self.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(injectLock);
+        if (!injected.empty()) {
+            task = injected.front();
+            injected.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    // steal the oldest, biggest piece, starting from a random victim
+    thread_local std::minstd_rand random(worker + 1);
+    int numWorkers = getNumThreads();
+    int first = static_cast<int>(random() % numWorkers);
+    for (int i = 0; i < numWorkers; i++) {
+        int victim = (first + i) % numWorkers;
+        if (victim == worker) { continue; }
+        Worker& other = *workers[victim];
+        std::lock_guard<std::mutex> lock(other.lock);
+        if (!other.tasks.empty()) {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+            queued--;
+            workers[worker]->tasksStolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** loop run by each worker thread */
+void ThreadPool::workerLoop(int worker) {
+    currentPool = this;
+    currentIndex = worker;
+    Task task;
+    while (true) {
+        if (findTask(worker, task)) {
+            execute(worker, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(injectLock);
+        if (stopping && queued.load() == 0) { return; }
+        // sleeping is raised before queued is checked and announceTask
+        // raises queued before checking sleeping, so one of the two sees
+        // the other and the wakeup cannot be missed
+        sleeping++;
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        sleeping--;
+    }
+}
+
+/** count a newly pushed task and wake a sleeping worker for it */
+void ThreadPool::announceTask() {
+    queued++;
+    if (sleeping.load() > 0) {
+        // a worker that saw queued == 0 holds injectLock until it waits
+        { std::lock_guard<std::mutex> lock(injectLock); }
+        wake.notify_one();
+    }
+}
@@ -0,0 +1,197 @@
+/**
+ * Work-stealing thread pool shared by the parallel graph algorithms
+ * Each worker has its own deque of tasks. A worker splits the range it
+ * is given in half, pushes one half on the bottom of its deque and keeps
+ * going with the other until the range is no bigger than the grain size,
+ * so the biggest pieces sit at the top where idle workers steal from
+ * parallelFor blocks until the whole range is done. Called from a worker
+ * (a nested loop) it runs tasks while it waits instead of sleeping
+ * parallelForWeighted splits by weight instead of by count, so one vertex
+ * with a million neighbors is spread over many tasks
+ * If f throws, the pieces not yet started are skipped and the first
+ * exception is rethrown by parallelFor once the running ones are done
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+ public:
+    /** counters for one worker since the last resetStats */
+    struct WorkerStats {
+        /** tasks run, including stolen ones */
+        uint64_t tasksRun {0};
+        /** tasks taken from another worker's deque */
+        uint64_t tasksStolen {0};
+        /** loop items processed */
+        uint64_t itemsRun {0};
+        /** time spent running tasks */
+        std::chrono::nanoseconds busyTime {0};
+        /** busy time divided by time since resetStats, 0 to 1 */
+        double utilization {0};
+    };
+
+    /** start numThreads workers, at least one */
+    explicit ThreadPool(
+        int numThreads = static_cast<int>(std::thread::hardware_concurrency()));
+
+    /** finish queued tasks and stop the workers */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** return number of worker threads */
+    int getNumThreads() const;
+
+    /** index of the calling worker in this pool, -1 for other threads */
+    int currentWorker() const;
+
+    /** call f(chunkBegin, chunkEnd) on pieces of [begin, end) of at most
+        grain items, in parallel, and wait for all of them
+        rethrows the first exception thrown by f */
+    template <typename F>
+    void parallelFor(long long begin, long long end, long long grain, F&& f);
+
+    /** prefix holds running totals of item weights, prefix[0] == 0 and
+        prefix[i + 1] - prefix[i] the weight of item i
+        calls f(item, from, to) for slices [from, to) of each item's weight,
+        every slice of at most grain weight, in parallel
+        items with no weight are skipped */
+    template <typename F>
+    void parallelForWeighted(const std::vector<long long>& prefix,
+                             long long grain, F&& f);
+
+    /** counters for each worker */
+    std::vector<WorkerStats> getStats() const;
+
+    /** zero the counters and restart the utilization clock */
+    void resetStats();
+
+ private:
+    /** one parallelFor call */
+    struct Job {
+        void (*run)(void* body, long long begin, long long end);
+        void* body;
+        long long grain;
+        std::atomic<long long> remaining;
+        /** set once a piece has thrown, later pieces are skipped */
+        std::atomic<bool> failed {false};
+        /** first exception thrown by a piece, set under doneLock */
+        std::exception_ptr error;
+        /** set under doneLock by whoever finishes the last piece */
+        std::atomic<bool> finished {false};
+        std::mutex doneLock;
+        std::condition_variable done;
+    };
+
+    /** a piece of a job */
+    struct Task {
+        Job* job;
+        long long begin;
+        long long end;
+    };
+
+    /** a worker's deque and counters */
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        std::atomic<uint64_t> tasksRun {0};
+        std::atomic<uint64_t> tasksStolen {0};
+        std::atomic<uint64_t> itemsRun {0};
+        std::atomic<int64_t> busyNanos {0};
+    };
+
+    /** run job over [begin, end) and wait for it */
+    void runJob(Job& job, long long begin, long long end);
+
+    /** split task down to job grain, pushing halves on worker's deque,
+        then run what is left */
+    void execute(int worker, Task task);
+
+    /** take a task: own deque bottom, then shared queue, then steal */
+    bool findTask(int worker, Task& task);
+
+    /** loop run by each worker thread */
+    void workerLoop(int worker);
+
+    /** count a newly pushed task and wake a sleeping worker for it */
+    void announceTask();
+
+    /** worker deques */
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /** threads running workerLoop */
+    std::vector<std::thread> threads;
+
+    /** tasks submitted from outside the pool */
+    std::deque<Task> injected;
+
+    /** guards injected, stopping and sleeping workers */
+    std::mutex injectLock;
+
+    /** wakes sleeping workers */
+    std::condition_variable wake;
+
+    /** tasks pushed but not yet taken */
+    std::atomic<long long> queued {0};
+
+    /** workers waiting on wake, changed under injectLock */
+    std::atomic<int> sleeping {0};
+
+    /** set by the destructor */
+    bool stopping {false};
+
+    /** when the stats were last reset, steady_clock nanoseconds */
+    std::atomic<int64_t> statsStart {0};
+};  // end ThreadPool
+
+/** call f(chunkBegin, chunkEnd) on pieces of [begin, end) in parallel */
+template <typename F>
+void ThreadPool::parallelFor(long long begin, long long end, long long grain,
+                             F&& f) {
+    if (begin >= end) { return; }
+    Job job;
+    job.run = [](void* body, long long b, long long e) {
+        (*static_cast<std::remove_reference_t<F>*>(body))(b, e);
+    };
+    job.body = &f;
+    job.grain = std::max(1LL, grain);
+    job.remaining = end - begin;
+    runJob(job, begin, end);
+}
+
+/** call f(item, from, to) on weight slices of each item in parallel */
+template <typename F>
+void ThreadPool::parallelForWeighted(const std::vector<long long>& prefix,
+                                     long long grain, F&& f) {
+    if (prefix.size() < 2) { return; }
+    parallelFor(prefix.front(), prefix.back(), grain,
+                [&prefix, &f](long long b, long long e) {
+        // first item whose weight range ends after b
+        size_t item = std::upper_bound(prefix.begin(), prefix.end(), b) -
+                      prefix.begin() - 1;
+        for (; item + 1 < prefix.size() && prefix[item] < e; item++) {
+            long long from = std::max(b, prefix[item]);
+            long long to = std::min(e, prefix[item + 1]);
+            if (from < to) {
+                f(static_cast<long long>(item), from - prefix[item],
+                  to - prefix[item]);
+            }
+        }
+    });
+}
+
+#endif  // THREADPOOL_H
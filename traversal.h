@@ -0,0 +1,268 @@
+/**
+ * Depth-first and breadth-first traversal for any graph representation
+ * A graph view only has to provide
+ *     const std::string& getLabel(int id) const
+ *     int getNumVertices() const
+ *     bool forEachNeighbor(int id, F f) const, calling f(endId, weight)
+ *          in neighbor order and stopping when f returns false
+ * Visitors can be any callable, including stateful lambdas
+ * They are called with a VertexHandle (or the label, if that is all
+ * they accept) and may return
+ *     void         keep going
+ *     bool         false stops the traversal
+ *     VisitAction  Continue, Prune (skip this vertex's neighbors) or Stop
+ *
+ * breadthFirstParallel needs a view with flat adjacency arrays, such as
+ * CsrGraph. It expands one level at a time on a ThreadPool and calls the
+ * visitor on the calling thread, in the same order as breadthFirst
+ */
+
+#ifndef TRAVERSAL_H
+#define TRAVERSAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "threadpool.h"
+
+/** what the traversal should do after visiting a vertex */
+enum class VisitAction { Continue, Prune, Stop };
+
+/** cheap reference to a vertex in a graph view
+    the label is only looked up if the visitor asks for it */
+template <typename GraphView>
+class VertexHandle {
+ public:
+    /** handle for vertex id in graph */
+    VertexHandle(const GraphView& graph, int id) : graph(&graph), id(id) {}
+
+    /** return the ID of the vertex */
+    int getId() const { return id; }
+
+    /** return the label of the vertex */
+    const std::string& getLabel() const { return graph->getLabel(id); }
+
+ private:
+    /** graph the vertex belongs to */
+    const GraphView* graph;
+
+    /** vertex ID in graph */
+    int id;
+};  // end VertexHandle
+
+namespace traversal {
+
+namespace detail {
+
+/** call visit with the handle, or its label, and turn the result
+    into a VisitAction */
+template <typename GraphView, typename Visitor>
+VisitAction callVisitor(Visitor& visit, const VertexHandle<GraphView>& v) {
+    using Handle = VertexHandle<GraphView>;
+    if constexpr (std::is_invocable_v<Visitor&, const Handle&>) {
+        using Result = std::invoke_result_t<Visitor&, const Handle&>;
+        if constexpr (std::is_void_v<Result>) {
+            visit(v);
+            return VisitAction::Continue;
+        } else if constexpr (std::is_same_v<Result, VisitAction>) {
+            return visit(v);
+        } else {
+            return visit(v) ? VisitAction::Continue : VisitAction::Stop;
+        }
+    } else {
+        using Result = std::invoke_result_t<Visitor&, const std::string&>;
+        if constexpr (std::is_void_v<Result>) {
+            visit(v.getLabel());
+            return VisitAction::Continue;
+        } else if constexpr (std::is_same_v<Result, VisitAction>) {
+            return visit(v.getLabel());
+        } else {
+            return visit(v.getLabel()) ? VisitAction::Continue
+                                       : VisitAction::Stop;
+        }
+    }
+}
+
+/** neighbors of id in graph order, into neighbors */
+template <typename GraphView>
+void collectNeighbors(const GraphView& graph, int id,
+                      std::vector<int>& neighbors) {
+    neighbors.clear();
+    graph.forEachNeighbor(id, [&neighbors](int endId, int) {
+        neighbors.push_back(endId);
+        return true;
+    });
+}
+
+}  // namespace detail
+
+/** depth-first traversal from startId, neighbors in graph order
+    walks with a stack on the heap instead of recursing, so long paths
+    cannot overflow the call stack; each level holds its vertex's
+    neighbors and how far through them it is, and a neighbor is checked
+    for a visit only when reached, so the order is that of recursion
+    returns false if the visitor stopped the traversal early */
+template <typename GraphView, typename Visitor>
+bool depthFirst(const GraphView& graph, int startId, Visitor&& visit) {
+    std::vector<char> visited(graph.getNumVertices(), 0);
+    visited[startId] = 1;
+    VisitAction action =
+        detail::callVisitor(visit, VertexHandle<GraphView>(graph, startId));
+    if (action == VisitAction::Stop) { return false; }
+    if (action == VisitAction::Prune) { return true; }
+    // neighbor lists by depth, kept when popped so deeper levels reuse
+    // their memory; next[d] is the place in level d's list to look at
+    std::vector<std::vector<int>> neighbors(1);
+    std::vector<size_t> next {0};
+    detail::collectNeighbors(graph, startId, neighbors[0]);
+    while (!next.empty()) {
+        size_t depth = next.size() - 1;
+        const std::vector<int>& list = neighbors[depth];
+        while (next[depth] < list.size() && visited[list[next[depth]]]) {
+            next[depth]++;
+        }
+        if (next[depth] == list.size()) {
+            next.pop_back();
+            continue;
+        }
+        int id = list[next[depth]++];
+        visited[id] = 1;
+        action =
+            detail::callVisitor(visit, VertexHandle<GraphView>(graph, id));
+        if (action == VisitAction::Stop) { return false; }
+        if (action == VisitAction::Prune) { continue; }
+        if (neighbors.size() == next.size()) { neighbors.emplace_back(); }
+        detail::collectNeighbors(graph, id, neighbors[next.size()]);
+        next.push_back(0);
+    }
+    return true;
+}
+
+/** breadth-first traversal from startId, neighbors in graph order
+    returns false if the visitor stopped the traversal early */
+template <typename GraphView, typename Visitor>
+bool breadthFirst(const GraphView& graph, int startId, Visitor&& visit) {
+    std::vector<char> visited(graph.getNumVertices(), 0);
+    // queue as a vector, everything pushed is popped in order
+    std::vector<int> queue;
+    visited[startId] = 1;
+    VisitAction action =
+        detail::callVisitor(visit, VertexHandle<GraphView>(graph, startId));
+    if (action == VisitAction::Stop) { return false; }
+    if (action == VisitAction::Continue) { queue.push_back(startId); }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        bool keepGoing = graph.forEachNeighbor(queue[head],
+                                               [&](int endId, int) {
+            if (visited[endId] != 0) { return true; }
+            visited[endId] = 1;
+            VisitAction a =
+                detail::callVisitor(visit, VertexHandle<GraphView>(graph,
+                                                                   endId));
+            if (a == VisitAction::Continue) { queue.push_back(endId); }
+            return a != VisitAction::Stop;
+        });
+        if (!keepGoing) { return false; }
+    }
+    return true;
+}
+
+/** breadth-first traversal from startId on pool, visits vertices in the
+    same order as breadthFirst
+    graph must provide getOffsets() and getTargets() as CsrGraph does
+    returns false if the visitor stopped the traversal early */
+template <typename GraphView, typename Visitor>
+bool breadthFirstParallel(const GraphView& graph, int startId,
+                          Visitor&& visit, ThreadPool& pool) {
+    // levels with fewer edges than this are expanded on the calling thread
+    const long long grain = 4096;
+    const std::vector<long long>& offsets = graph.getOffsets();
+    const std::vector<int>& targets = graph.getTargets();
+    int n = graph.getNumVertices();
+    std::vector<char> visited(n, 0);
+    // lowest (place in level, place in neighbor list) reaching each vertex,
+    // stored complemented so 0 means unclaimed and fetch-max keeps the min
+    std::vector<std::atomic<unsigned long long>> claim(n);
+    std::vector<int> level;
+    std::vector<int> frontier;
+    visited[startId] = 1;
+    level.push_back(startId);
+    std::vector<long long> prefix;
+    while (!level.empty()) {
+        frontier.clear();
+        for (int v : level) {
+            VisitAction action =
+                detail::callVisitor(visit, VertexHandle<GraphView>(graph, v));
+            if (action == VisitAction::Stop) { return false; }
+            if (action == VisitAction::Continue) { frontier.push_back(v); }
+        }
+        level.clear();
+        prefix.assign(1, 0);
+        for (int v : frontier) {
+            prefix.push_back(prefix.back() + offsets[v + 1] - offsets[v]);
+        }
+        long long numEdges = prefix.back();
+        if (numEdges < grain) {
+            for (int v : frontier) {
+                for (long long i = offsets[v]; i < offsets[v + 1]; i++) {
+                    if (visited[targets[i]] == 0) {
+                        visited[targets[i]] = 1;
+                        level.push_back(targets[i]);
+                    }
+                }
+            }
+            continue;
+        }
+        // claim: every unvisited neighbor keeps its earliest edge
+        pool.parallelForWeighted(prefix, grain,
+                                 [&](long long item, long long from,
+                                     long long to) {
+            long long base = offsets[frontier[item]];
+            for (long long j = from; j < to; j++) {
+                int u = targets[base + j];
+                if (visited[u] != 0) { continue; }
+                unsigned long long key = ~(static_cast<unsigned long long>(
+                    item) << 32 | static_cast<unsigned long long>(j));
+                unsigned long long old = claim[u].load();
+                while (old < key && !claim[u].compare_exchange_weak(old, key)) {
+                }
+            }
+        });
+        // collect: the edge that won each claim, chunks in edge order
+        long long numChunks = (numEdges + grain - 1) / grain;
+        std::vector<std::vector<int>> found(numChunks);
+        pool.parallelFor(0, numChunks, 1, [&](long long first,
+                                              long long last) {
+            for (long long c = first; c < last; c++) {
+                long long from = c * grain;
+                long long to = std::min(numEdges, from + grain);
+                size_t item = std::upper_bound(prefix.begin(), prefix.end(),
+                                               from) - prefix.begin() - 1;
+                for (long long e = from; e < to; e++) {
+                    while (prefix[item + 1] <= e) { item++; }
+                    long long j = e - prefix[item];
+                    int u = targets[offsets[frontier[item]] + j];
+                    unsigned long long key = ~(static_cast<unsigned long long>(
+                        item) << 32 | static_cast<unsigned long long>(j));
+                    if (visited[u] == 0 && claim[u].load() == key) {
+                        found[c].push_back(u);
+                    }
+                }
+            }
+        });
+        for (const auto& chunk : found) {
+            for (int u : chunk) {
+                visited[u] = 1;
+                level.push_back(u);
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace traversal
+
+#endif  // TRAVERSAL_H
@@ -18,17 +18,30 @@
 /** Creates an unvisited vertex, gives it a label, and clears its
     adjacency list.
     NOTE: A vertex must have a unique label that cannot be changed. */
-Vertex::Vertex(std::string label) {
+Vertex::Vertex(std::string label, int id, NeighborOrder order) {
     vertexLabel = label;   
+    vertexId = id;
+    labelHash = LabelHashMap<Edge>::hashLabel(vertexLabel);
+    neighborOrder = order;
     adjacencyList.clear(); 
     currentNeighbor = adjacencyList.begin();
 }
 
 /** @return  The label of this vertex. */
-std::string Vertex::getLabel() const { 
+const std::string& Vertex::getLabel() const { 
     return vertexLabel; 
 }
 
+/** @return  Hash of the label, computed once by the constructor. */
+size_t Vertex::getLabelHash() const {
+    return labelHash;
+}
+
+/** @return  The graph ID of this vertex, -1 if not owned by a graph. */
+int Vertex::getId() const {
+    return vertexId;
+}
+
 /** Marks this vertex as visited. */
 void Vertex::visit() {
     visited = true;
@@ -49,20 +62,71 @@ bool Vertex::isVisited() const {
 /** Adds an edge between this vertex and the given vertex.
     Cannot have multiple connections to the same endVertex
     Cannot connect back to itself
+    endId is the graph ID of endVertex, kept in the edge for traversals
  @return  True if the connection is successful. */
-bool Vertex::connect(const std::string& endVertex, const int edgeWeight) { 
-    if (endVertex != getLabel() && adjacencyList.count(endVertex) == 0) {
-        Edge path(endVertex, edgeWeight);
-        adjacencyList[endVertex] = path;
-        resetNeighbor();
-        return true;
+bool Vertex::connect(const std::string& endVertex, const int edgeWeight,
+                     const int endId) { 
+    if (endVertex == getLabel()) { return false; }
+    size_t endHash = neighborOrder == NeighborOrder::Insertion
+                     ? LabelHashMap<Edge>::hashLabel(endVertex) : 0;
+    return insertEdge(endVertex, endHash,
+                      Edge(endVertex, edgeWeight, endId));
+}
+
+/** Adds an edge between this vertex and endVertex, same rules as above.
+    Reuses the ID and label hash already stored in endVertex.
+ @return  True if the connection is successful. */
+bool Vertex::connect(const Vertex& endVertex, const int edgeWeight) {
+    if (endVertex.getLabel() == getLabel()) { return false; }
+    return insertEdge(endVertex.getLabel(), endVertex.getLabelHash(),
+                      Edge(endVertex.getLabel(), edgeWeight,
+                           endVertex.getId()));
+}
+
+/** Adds an edge to each of the count (endVertex, edgeWeight) pairs
+    in targets, same rules as connect. For NeighborOrder::Alphabetical
+    targets should be sorted by label so each insert lands next to the
+    last.
+ @return  The number of edges added. */
+int Vertex::connectAll(const std::pair<const Vertex*, int>* targets,
+                       int count) {
+    int added = 0;
+    if (neighborOrder == NeighborOrder::Insertion) {
+        hashedAdjacencyList.reserve(hashedAdjacencyList.size() + count);
+        for (int i = 0; i < count; i++) {
+            const auto& [endVertex, edgeWeight] = targets[i];
+            if (endVertex->getLabel() == getLabel()) { continue; }
+            Edge path(endVertex->getLabel(), edgeWeight, endVertex->getId());
+            if (hashedAdjacencyList.insert(endVertex->getLabel(),
+                                           endVertex->getLabelHash(),
+                                           path).second) {
+                added++;
+            }
+        }
+    } else {
+        auto hint = adjacencyList.end();
+        for (int i = 0; i < count; i++) {
+            const auto& [endVertex, edgeWeight] = targets[i];
+            if (endVertex->getLabel() == getLabel()) { continue; }
+            size_t before = adjacencyList.size();
+            Edge path(endVertex->getLabel(), edgeWeight, endVertex->getId());
+            hint = std::next(adjacencyList.emplace_hint(
+                hint, endVertex->getLabel(), path));
+            if (adjacencyList.size() != before) { added++; }
+        }
     }
-    return false;
+    resetNeighbor();
+    return added;
 }
 
 /** Removes the edge between this vertex and the given one.
 @return  True if the removal is successful. */
 bool Vertex::disconnect(const std::string& endVertex) {
+    if (neighborOrder == NeighborOrder::Insertion) {
+        bool removed = hashedAdjacencyList.erase(endVertex);
+        resetNeighbor();
+        return removed;
+    }
     if (adjacencyList.find(endVertex) != adjacencyList.end()) {
         adjacencyList.erase(endVertex);
         resetNeighbor();
@@ -75,6 +139,10 @@ bool Vertex::disconnect(const std::string& endVertex) {
  @return  The edge weight. This value is zero for an unweighted graph and
     is negative if the .edge does not exist */
 int Vertex::getEdgeWeight(const std::string& endVertex) const { 
+    if (neighborOrder == NeighborOrder::Insertion) {
+        const Edge* path = hashedAdjacencyList.find(endVertex);
+        return path == nullptr ? -1 : path->getWeight();
+    }
     if (adjacencyList.count(endVertex) != 0) {
         return adjacencyList.at(endVertex).getWeight();
     }
@@ -84,19 +152,31 @@ int Vertex::getEdgeWeight(const std::string& endVertex) const {
 /** Calculates how many neighbors this vertex has.
  @return  The number of the vertex's neighbors. */
 int Vertex::getNumberOfNeighbors() const {
+    if (neighborOrder == NeighborOrder::Insertion) {
+        return hashedAdjacencyList.size();
+    }
     return adjacencyList.size();
 }
 
 /** Sets current neighbor to first in adjacency list. */
 void Vertex::resetNeighbor() {
+    currentHashedNeighbor = 0;
     currentNeighbor = adjacencyList.begin();
 }
 
 /** Gets this vertex's next neighbor in the adjacency list.
     Neighbors are automatically sorted alphabetically via map
+    (in connect order for NeighborOrder::Insertion)
     Returns the vertex label if there are no more neighbors
  @return  The label of the vertex's next neighbor. */
 std::string Vertex::getNextNeighbor() {
+    if (neighborOrder == NeighborOrder::Insertion) {
+        if (currentHashedNeighbor == hashedAdjacencyList.size()) {
+            resetNeighbor();
+            return vertexLabel;
+        }
+        return hashedAdjacencyList.entryAt(currentHashedNeighbor++).first;
+    }
     if (currentNeighbor == adjacencyList.end()) {
         resetNeighbor();
         return vertexLabel;
@@ -120,3 +200,15 @@ bool Vertex::operator<(const Vertex& rightHandItem) const {
     return (getLabel() < rightHandItem.getLabel());
 }
 
+/** add path to the adjacency list in use, true if it was not there */
+bool Vertex::insertEdge(const std::string& endVertex, size_t endHash,
+                        const Edge& path) {
+    bool inserted;
+    if (neighborOrder == NeighborOrder::Insertion) {
+        inserted = hashedAdjacencyList.insert(endVertex, endHash, path).second;
+    } else {
+        inserted = adjacencyList.emplace(endVertex, path).second;
+    }
+    if (inserted) { resetNeighbor(); }
+    return inserted;
+}
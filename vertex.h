@@ -12,18 +12,36 @@
 #include <functional>
 #include <map>
 #include <string>
+#include <utility>
 
 #include "edge.h"
+#include "labelhashmap.h"
+
+/** How neighbors are stored and the order they are visited in. */
+enum class NeighborOrder {
+    /** std::map, neighbors in alphabetical order, O(log n) lookups */
+    Alphabetical,
+    /** LabelHashMap, neighbors in the order they were connected
+        (disconnect moves the last neighbor into the gap), O(1) lookups */
+    Insertion
+};
 
 class Vertex {
  public:
     /** Creates an unvisited vertex, gives it a label, and clears its
         adjacency list.
         NOTE: A vertex must have a unique label that cannot be changed. */
-    explicit Vertex(std::string label);
+    explicit Vertex(std::string label, int id = -1,
+                    NeighborOrder order = NeighborOrder::Alphabetical);
 
     /** @return  The label of this vertex. */
-    std::string getLabel() const;
+    const std::string& getLabel() const;
+
+    /** @return  Hash of the label, computed once by the constructor. */
+    size_t getLabelHash() const;
+
+    /** @return  The graph ID of this vertex, -1 if not owned by a graph. */
+    int getId() const;
 
     /** Marks this vertex as visited. */
     void visit();
@@ -39,8 +57,23 @@ class Vertex {
     /** Adds an edge between this vertex and the given vertex.
         Cannot have multiple connections to the same endVertex
         Cannot connect back to itself
+        endId is the graph ID of endVertex, kept in the edge for traversals
      @return  True if the connection is successful. */
-    bool connect(const std::string& endVertex, const int edgeWeight = 0);
+    bool connect(const std::string& endVertex, const int edgeWeight = 0,
+                 const int endId = -1);
+
+    /** Adds an edge between this vertex and endVertex, same rules as above.
+        Reuses the ID and label hash already stored in endVertex.
+     @return  True if the connection is successful. */
+    bool connect(const Vertex& endVertex, const int edgeWeight);
+
+    /** Adds an edge to each of the count (endVertex, edgeWeight) pairs
+        in targets, same rules as connect. For NeighborOrder::Alphabetical
+        targets should be sorted by label so each insert lands next to the
+        last.
+     @return  The number of edges added. */
+    int connectAll(const std::pair<const Vertex*, int>* targets,
+                   int count);
 
     /** Removes the edge between this vertex and the given one.
     @return  True if the removal is successful. */
@@ -60,10 +93,29 @@ class Vertex {
 
     /** Gets this vertex's next neighbor in the adjacency list.
         Neighbors are automatically sorted alphabetically via map
+        (in connect order for NeighborOrder::Insertion)
         Returns the vertex label if there are no more neighbors
      @return  The label of the vertex's next neighbor. */
     std::string getNextNeighbor();
 
+    /** Calls f on each outgoing edge in adjacency list order.
+        Does not touch the getNextNeighbor position, so several
+        traversals can walk the same vertex.
+     @return  False if f returned false and stopped the walk early. */
+    template <typename F>
+    bool forEachEdge(F&& f) const {
+        if (neighborOrder == NeighborOrder::Insertion) {
+            for (const auto& entry : hashedAdjacencyList) {
+                if (!f(entry.second)) { return false; }
+            }
+            return true;
+        }
+        for (const auto& entry : adjacencyList) {
+            if (!f(entry.second)) { return false; }
+        }
+        return true;
+    }
+
     /** Sees whether this vertex is equal to another one.
         Two vertices are equal if they have the same label. */
     bool operator==(const Vertex& rightHandItem) const;
@@ -76,6 +128,15 @@ class Vertex {
     /** the unique label for the vertex */
     std::string vertexLabel;
 
+    /** index of this vertex in its graph */
+    int vertexId {-1};
+
+    /** hash of vertexLabel */
+    size_t labelHash {0};
+
+    /** which of the two adjacency lists is in use */
+    NeighborOrder neighborOrder {NeighborOrder::Alphabetical};
+
     /** True if the vertex is visited */
     bool visited {false};
 
@@ -84,6 +145,16 @@ class Vertex {
 
     /** iterator showing which neighbor we are currently at */
     std::map<std::string, Edge>::iterator currentNeighbor;
+
+    /** adjacencyList as a hash map, in order of insertion */
+    LabelHashMap<Edge> hashedAdjacencyList;
+
+    /** index of current neighbor in hashedAdjacencyList */
+    int currentHashedNeighbor {0};
+
+    /** add path to the adjacency list in use, true if it was not there */
+    bool insertEdge(const std::string& endVertex, size_t endHash,
+                    const Edge& path);
 };
 
 #endif  // VERTEX_H